@@ -1,64 +1,773 @@
 #include "qg_bus.hpp"
+#include <atomic>
 #include <cstring>
+#include <new>
+
+#if BUS_STATS
+#include <chrono>
+#include <cstdio>
+#endif
+
+// ===== CROSS-THREAD QUEUE =====
+// Bounded multi-producer ring (one sequence number per cell): producers claim a ticket
+// with a CAS on enqueue_pos and publish the cell by bumping its sequence, the main thread
+// consumes cells in ticket order. Payloads are copied into 16 KB chunks that each producer
+// thread owns in turn, so fires from different threads never share an allocator; a chunk
+// goes back to the free list once its owner has moved on and every event using it drained.
+
+#define BUS_ASYNC_NO_CHUNK 0xFFFFFFFF
+
+struct bus_async_chunk {
+    u8 data[BUS_ASYNC_CHUNK_SIZE];
+    std::atomic<u32> refs;        // Owning producer + queued events pointing into data
+    std::atomic<u32> next_free;   // Free list link, chunk index + 1 (0 ends the list)
+};
+
+struct bus_async_cell {
+    std::atomic<u32> sequence;    // == ticket: free, == ticket + 1: published
+    event_type type;
+    u32 data_size;
+    u32 chunk;
+    u8* data;
+};
+
+struct bus_async_queue {
+    alignas(64) std::atomic<u32> enqueue_pos;
+    alignas(64) u32 dequeue_pos;              // Main thread only
+    alignas(64) std::atomic<u64> free_head;   // ABA tag << 32 | (chunk index + 1)
+    u64 epoch;                                // Tells producers a chunk belongs to this queue
+    void* block;                              // What qg_malloc returned, the queue is aligned up in it
+    bus_async_cell cells[BUS_ASYNC_RING_SIZE];
+    bus_async_chunk chunks[BUS_ASYNC_NUM_CHUNKS];
+#if BUS_STATS
+    std::atomic<u64> dropped;                 // Refused fires since the last drain
+#endif
+};
+
+// The chunk the calling thread is filling
+struct bus_async_producer {
+    u64 epoch;  // bus_async_queue::epoch of the chunk's queue, 0 = no chunk
+    u32 chunk;
+    u32 used;
+};
+
+static thread_local bus_async_producer t_producer;
+static std::atomic<u64> g_async_epoch { 0 };
+
+static void bus_chunk_push(bus_async_queue* q, u32 idx) {
+    u64 head = q->free_head.load(std::memory_order_relaxed);
+    for (;;) {
+        q->chunks[idx].next_free.store((u32)head, std::memory_order_relaxed);
+        u64 next = (((head >> 32) + 1) << 32) | (idx + 1);
+        if (q->free_head.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+static u32 bus_chunk_pop(bus_async_queue* q) {
+    u64 head = q->free_head.load(std::memory_order_acquire);
+    for (;;) {
+        u32 top = (u32)head;
+        if (top == 0) {
+            return BUS_ASYNC_NO_CHUNK;
+        }
+        u32 next = q->chunks[top - 1].next_free.load(std::memory_order_relaxed);
+        u64 desired = (((head >> 32) + 1) << 32) | next;
+        if (q->free_head.compare_exchange_weak(head, desired, std::memory_order_acquire, std::memory_order_acquire)) {
+            return top - 1;
+        }
+    }
+}
+
+static void bus_chunk_release(bus_async_queue* q, u32 idx) {
+    if (q->chunks[idx].refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        bus_chunk_push(q, idx);
+    }
+}
+
+static inline void bus_async_dropped(bus_async_queue* q) {
+#if BUS_STATS
+    q->dropped.fetch_add(1, std::memory_order_relaxed);
+#else
+    (void)q;
+#endif
+}
+
+// qg_malloc only guarantees 16 bytes, the queue's members need alignof(bus_async_queue)
+static bus_async_queue* bus_async_create() {
+    const u64 align = alignof(bus_async_queue);
+    void* block = qg_malloc(sizeof(bus_async_queue) + align - 1);
+    void* at = (void*)(((uintptr_t)block + align - 1) & ~(uintptr_t)(align - 1));
+    bus_async_queue* q = new (at) bus_async_queue;
+    q->block = block;
+    q->enqueue_pos.store(0, std::memory_order_relaxed);
+    q->dequeue_pos = 0;
+    q->free_head.store(0, std::memory_order_relaxed);
+    q->epoch = ++g_async_epoch;
+#if BUS_STATS
+    q->dropped.store(0, std::memory_order_relaxed);
+#endif
+
+    for (u32 i = 0; i < BUS_ASYNC_RING_SIZE; i++) {
+        q->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    for (u32 i = BUS_ASYNC_NUM_CHUNKS; i > 0; i--) {
+        q->chunks[i - 1].refs.store(0, std::memory_order_relaxed);
+        bus_chunk_push(q, i - 1);
+    }
+    return q;
+}
+
+// Moves published cross-thread events into the frame queue, oldest ticket first.
+// Stops at the first ticket still being written, or when the frame queue is full;
+// whatever is left stays queued for the next bus_process.
+static void bus_async_drain(event_bus* bus) {
+    bus_async_queue* q = bus->async;
+    u32 end = q->enqueue_pos.load(std::memory_order_acquire);
+
+#if BUS_STATS
+    u64 dropped = q->dropped.exchange(0, std::memory_order_relaxed);
+    bus->stats->drops[BUS_DROP_ASYNC] += dropped;
+    bus->stats->frame_drops += dropped;
+#endif
+
+    while (q->dequeue_pos != end) {
+        bus_async_cell& cell = q->cells[q->dequeue_pos & BUS_ASYNC_MASK];
+        if (cell.sequence.load(std::memory_order_acquire) != q->dequeue_pos + 1) {
+            break;
+        }
+        if (!bus_fire(bus, cell.type, cell.data, cell.data_size)) {
+            break;
+        }
+
+        bus_chunk_release(q, cell.chunk);
+        cell.sequence.store(q->dequeue_pos + BUS_ASYNC_RING_SIZE, std::memory_order_release);
+        q->dequeue_pos++;
+    }
+}
+
+// ===== TIMER WHEEL =====
+// Scheduled events wait in a hierarchical wheel of BUS_TIMER_LEVELS x 64 slots. Level 0 holds
+// timers due within the current 64-tick span, one slot per tick; level l holds spans of
+// 64^l ticks. A timer goes in the lowest level whose span still contains its due tick, so
+// insert and cancel are a list append/unlink. When the tick crosses a span boundary the
+// matching slot of each higher level is re-inserted one level down (highest level first),
+// and the level 0 slot for the tick is fired. Timers further out than the top level wait
+// in an overflow list that is re-inserted each time the top level wraps.
+//
+// Slot lists are intrusive and append at the tail, which keeps timers due the same tick in
+// the order they were scheduled through every cascade.
+
+#define BUS_TIMER_LEVELS 4
+#define BUS_TIMER_SLOT_BITS 6
+#define BUS_TIMER_SLOTS (1 << BUS_TIMER_SLOT_BITS)
+#define BUS_TIMER_SLOT_MASK (BUS_TIMER_SLOTS - 1)
+#define BUS_TIMER_OVERFLOW (BUS_TIMER_LEVELS * BUS_TIMER_SLOTS)  // List index of the overflow list
+#define BUS_TIMER_NUM_LISTS (BUS_TIMER_OVERFLOW + 1)
+#define BUS_NO_TIMER 0xFFFF
+
+struct bus_timer {
+    u64 due;
+    u32 generation;         // Incremented each time the timer is reused
+    u16 prev;
+    u16 next;               // Also the free list link
+    u16 list;               // Wheel list the timer is in, BUS_NO_TIMER when free
+    event_type type;
+    u32 data_size;
+    alignas(8) u8 data[BUS_TIMER_MAX_DATA];
+};
+
+struct bus_timer_list {
+    u16 head;
+    u16 tail;
+};
+
+struct bus_timer_wheel {
+    bus_timer_list lists[BUS_TIMER_NUM_LISTS];
+    bus_timer timers[BUS_MAX_TIMERS];
+    u16 free_head;
+    u32 count;
+};
+
+static bus_timer_wheel* bus_timers_create() {
+    bus_timer_wheel* w = (bus_timer_wheel*)qg_malloc(sizeof(bus_timer_wheel));
+    for (u32 i = 0; i < BUS_TIMER_NUM_LISTS; i++) {
+        w->lists[i].head = BUS_NO_TIMER;
+        w->lists[i].tail = BUS_NO_TIMER;
+    }
+    for (u32 i = 0; i < BUS_MAX_TIMERS; i++) {
+        w->timers[i].generation = 0;
+        w->timers[i].list = BUS_NO_TIMER;
+        w->timers[i].next = i + 1 < BUS_MAX_TIMERS ? (u16)(i + 1) : BUS_NO_TIMER;
+    }
+    w->free_head = 0;
+    w->count = 0;
+    return w;
+}
+
+// Wheel list for a timer due at `due`, seen from tick `now` (due > now)
+static u16 bus_timer_list_for(u64 due, u64 now) {
+    u64 diff = due ^ now;
+    for (u32 level = 0; level < BUS_TIMER_LEVELS; level++) {
+        u32 shift = level * BUS_TIMER_SLOT_BITS;
+        if ((diff >> (shift + BUS_TIMER_SLOT_BITS)) == 0) {
+            return (u16)(level * BUS_TIMER_SLOTS + ((due >> shift) & BUS_TIMER_SLOT_MASK));
+        }
+    }
+    return BUS_TIMER_OVERFLOW;
+}
+
+static void bus_timer_link(bus_timer_wheel* w, u16 idx, u16 list_idx) {
+    bus_timer& t = w->timers[idx];
+    bus_timer_list& list = w->lists[list_idx];
+    t.list = list_idx;
+    t.prev = list.tail;
+    t.next = BUS_NO_TIMER;
+    if (list.tail != BUS_NO_TIMER) {
+        w->timers[list.tail].next = idx;
+    } else {
+        list.head = idx;
+    }
+    list.tail = idx;
+}
+
+static void bus_timer_unlink(bus_timer_wheel* w, u16 idx) {
+    bus_timer& t = w->timers[idx];
+    bus_timer_list& list = w->lists[t.list];
+    if (t.prev != BUS_NO_TIMER) w->timers[t.prev].next = t.next;
+    else list.head = t.next;
+    if (t.next != BUS_NO_TIMER) w->timers[t.next].prev = t.prev;
+    else list.tail = t.prev;
+}
+
+static void bus_timer_release(bus_timer_wheel* w, u16 idx) {
+    bus_timer& t = w->timers[idx];
+    t.list = BUS_NO_TIMER;
+    t.next = w->free_head;
+    w->free_head = idx;
+    w->count--;
+}
+
+// Moves every timer of a list to where it belongs as of bus->tick, keeping their order
+static void bus_timers_cascade(event_bus* bus, u16 list_idx) {
+    bus_timer_wheel* w = bus->timers;
+    u16 idx = w->lists[list_idx].head;
+    w->lists[list_idx].head = BUS_NO_TIMER;
+    w->lists[list_idx].tail = BUS_NO_TIMER;
+
+    while (idx != BUS_NO_TIMER) {
+        u16 next = w->timers[idx].next;
+        bus_timer_link(w, idx, bus_timer_list_for(w->timers[idx].due, bus->tick));
+        idx = next;
+    }
+}
+
+// The queue filled up before a slot was fired: its remaining timers go out first next tick
+static void bus_timers_defer(event_bus* bus, u16 list_idx) {
+    bus_timer_wheel* w = bus->timers;
+    bus_timer_list& from = w->lists[list_idx];
+    u16 to_idx = bus_timer_list_for(bus->tick + 1, bus->tick);
+    bus_timer_list& to = w->lists[to_idx];
+
+    for (u16 idx = from.head; idx != BUS_NO_TIMER; idx = w->timers[idx].next) {
+        w->timers[idx].due = bus->tick + 1;
+        w->timers[idx].list = to_idx;
+    }
+    w->timers[from.tail].next = to.head;
+    if (to.head != BUS_NO_TIMER) {
+        w->timers[to.head].prev = from.tail;
+    } else {
+        to.tail = from.tail;
+    }
+    to.head = from.head;
+    from.head = BUS_NO_TIMER;
+    from.tail = BUS_NO_TIMER;
+}
+
+// Advances the wheel to bus->tick and queues the timers due on it
+static void bus_timers_advance(event_bus* bus) {
+    bus_timer_wheel* w = bus->timers;
+    if (w->count == 0) {
+        return;
+    }
+
+    u64 tick = bus->tick;
+    if ((tick & ((1ull << (BUS_TIMER_LEVELS * BUS_TIMER_SLOT_BITS)) - 1)) == 0) {
+        bus_timers_cascade(bus, BUS_TIMER_OVERFLOW);
+    }
+    for (u32 level = BUS_TIMER_LEVELS - 1; level > 0; level--) {
+        u32 shift = level * BUS_TIMER_SLOT_BITS;
+        if ((tick & ((1ull << shift) - 1)) == 0) {
+            bus_timers_cascade(bus, (u16)(level * BUS_TIMER_SLOTS + ((tick >> shift) & BUS_TIMER_SLOT_MASK)));
+        }
+    }
+
+    bus_timer_list& due = w->lists[tick & BUS_TIMER_SLOT_MASK];
+    while (due.head != BUS_NO_TIMER) {
+        u16 idx = due.head;
+        bus_timer& t = w->timers[idx];
+        if (!bus_fire(bus, t.type, t.data, t.data_size)) {
+            bus_timers_defer(bus, tick & BUS_TIMER_SLOT_MASK);
+            break;
+        }
+        bus_timer_unlink(w, idx);
+        bus_timer_release(w, idx);
+    }
+}
+
+// ===== INSTRUMENTATION =====
+#if BUS_STATS
+static inline u64 bus_stats_now_ns() {
+    return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline bus_type_stats* bus_stats_type(event_bus* bus, event_type type) {
+    return (u32)type < (u32)event_type::COUNT ? &bus->stats->types[(u32)type] : nullptr;
+}
+
+static void bus_stats_drop(event_bus* bus, event_type type, bus_drop_reason reason) {
+    bus_stats* st = bus->stats;
+    st->drops[reason]++;
+    st->frame_drops++;
+    if (bus_type_stats* ts = bus_stats_type(bus, type)) {
+        ts->dropped++;
+    }
+}
+
+static void bus_stats_handler(event_bus* bus, event_type type, u64 ns) {
+    bus_stats* st = bus->stats;
+    if (ns > st->frame_max_handler_ns) {
+        st->frame_max_handler_ns = ns;
+    }
+
+    bus_type_stats* ts = bus_stats_type(bus, type);
+    if (!ts) {
+        return;
+    }
+    ts->handler_calls++;
+    ts->handler_ns += ns;
+    if (ns > ts->handler_max_ns) {
+        ts->handler_max_ns = ns;
+    }
+
+    u32 bucket = 0;
+    for (u64 limit = 128; ns >= limit && bucket < BUS_STATS_HISTOGRAM_BUCKETS - 1; limit <<= 1) {
+        bucket++;
+    }
+    ts->handler_histogram[bucket]++;
+}
+
+static void bus_stats_budget(event_bus* bus, const char* name, f32 current, f32 budget) {
+    perf_budget_exceeded_event e;
+    e.budget_name = name;
+    e.current_value = current;
+    e.budget_value = budget;
+    if (bus_fire(bus, event_type::PERF_BUDGET_EXCEEDED, &e, sizeof(e))) {
+        bus->stats->budget_events++;
+    }
+}
+
+// Called once the bus_process is over and the queue reset, so budget events go to the next one
+static void bus_stats_end_process(event_bus* bus, u32 queued, u64 payload_bytes, u32 undispatched) {
+    bus_stats* st = bus->stats;
+    st->processes++;
+    if (undispatched > 0) {
+        st->truncated_processes++;
+        st->truncated_events += undispatched;
+    }
+
+    if (st->budget_queue_events > 0 && queued > st->budget_queue_events) {
+        bus_stats_budget(bus, "bus_queue_events", (f32)queued, (f32)st->budget_queue_events);
+    }
+    if (st->budget_payload_bytes > 0 && payload_bytes > st->budget_payload_bytes) {
+        bus_stats_budget(bus, "bus_payload_bytes", (f32)payload_bytes, (f32)st->budget_payload_bytes);
+    }
+    if (st->budget_handler_ns > 0 && st->frame_max_handler_ns > st->budget_handler_ns) {
+        bus_stats_budget(bus, "bus_handler_ns", (f32)st->frame_max_handler_ns, (f32)st->budget_handler_ns);
+    }
+    if (st->frame_drops > 0) {
+        bus_stats_budget(bus, "bus_dropped_events", (f32)st->frame_drops, 0.0f);
+    }
+    if (undispatched > 0) {
+        bus_stats_budget(bus, "bus_truncated_events", (f32)undispatched, 0.0f);
+    }
+
+    st->frame_drops = 0;
+    st->frame_max_handler_ns = 0;
+}
+
+void bus_stats_reset(event_bus* bus) {
+    bus_stats* st = bus->stats;
+    u32 budget_queue_events = st->budget_queue_events;
+    u64 budget_payload_bytes = st->budget_payload_bytes;
+    u64 budget_handler_ns = st->budget_handler_ns;
+
+    memset(st, 0, sizeof(bus_stats));
+    st->budget_queue_events = budget_queue_events;
+    st->budget_payload_bytes = budget_payload_bytes;
+    st->budget_handler_ns = budget_handler_ns;
+}
+
+void bus_stats_print(event_bus* bus) {
+    bus_stats* st = bus->stats;
+    printf("[BUS] %llu processes, queue high-water %u, peak frame %u events / %llu payload bytes, %u pages (%llu bytes)\n",
+           st->processes, st->queue_high_water, bus->peak_events, bus->peak_payload_bytes, bus->num_pages, bus->payload_capacity);
+    printf("[BUS] dropped: queue %llu, page %llu, async %llu, timers %llu; truncated %llu processes (%llu events); %llu budget events\n",
+           st->drops[BUS_DROP_QUEUE_FULL], st->drops[BUS_DROP_PAGE_FAILED], st->drops[BUS_DROP_ASYNC],
+           st->drops[BUS_DROP_TIMERS_FULL], st->truncated_processes, st->truncated_events, st->budget_events);
+
+    for (u32 i = 0; i < (u32)event_type::COUNT; i++) {
+        bus_type_stats& ts = st->types[i];
+        if (ts.fired == 0 && ts.dispatched == 0 && ts.dropped == 0) continue;
+
+        f64 avg_ns = ts.handler_calls > 0 ? (f64)ts.handler_ns / ts.handler_calls : 0.0;
+        printf("[BUS] type %4u: fired %llu dispatched %llu bytes %llu dropped %llu, %llu calls avg %.0f ns max %llu ns |",
+               i, ts.fired, ts.dispatched, ts.bytes, ts.dropped, ts.handler_calls, avg_ns, ts.handler_max_ns);
+        for (u32 b = 0; b < BUS_STATS_HISTOGRAM_BUCKETS; b++) {
+            printf(" %u", ts.handler_histogram[b]);
+        }
+        printf("\n");
+    }
+}
+#endif
+
+// ===== PAYLOAD PAGES =====
+
+// For the slow paths of bus_fire: inlined, they cost the common case about a third
+#if defined(_MSC_VER)
+#define BUS_NOINLINE __declspec(noinline)
+#else
+#define BUS_NOINLINE __attribute__((noinline))
+#endif
+
+static bus_page* bus_page_create(u64 capacity) {
+    bus_page* page = (bus_page*)qg_malloc(sizeof(bus_page) + capacity);
+    if (page) {
+        page->next = nullptr;
+        page->capacity = capacity;
+    }
+    return page;
+}
+
+static inline u8* bus_page_data(bus_page* page) {
+    return (u8*)(page + 1);
+}
+
+static inline void bus_page_start(event_bus* bus, bus_page* page) {
+    bus->page = page;
+    bus->cursor = bus_page_data(page);
+    bus->cursor_end = bus->cursor + page->capacity;
+}
+
+// Payload bytes used this frame
+static inline u64 bus_payload_used(event_bus* bus) {
+    return bus->payload_bytes + (u64)(bus->cursor - bus_page_data(bus->page));
+}
+
+// Moves on to the next page, for a size that doesn't fit in the current one. Pages after the
+// current one are all unused this frame: the first big enough is moved up to be next, and a
+// new page is only allocated when none is. Returns false only if that allocation fails.
+BUS_NOINLINE static bool bus_page_next(event_bus* bus, u64 size) {
+    bus_page* page = bus->page;
+    bus_page** link = &page->next;
+    while (*link && (*link)->capacity < size) {
+        link = &(*link)->next;
+    }
+
+    bus_page* next = *link;
+    if (next) {
+        *link = next->next;
+    } else {
+        next = bus_page_create(size > BUS_PAGE_SIZE ? size : BUS_PAGE_SIZE);
+        if (!next) {
+            return false;
+        }
+        bus->num_pages++;
+        bus->payload_capacity += next->capacity;
+    }
+    next->next = page->next;
+    page->next = next;
+
+    bus->payload_bytes += (u64)(bus->cursor - bus_page_data(page));
+    bus_page_start(bus, next);
+    return true;
+}
+
+// Room for size bytes in the current page, or the next one
+static inline u8* bus_page_alloc(event_bus* bus, u64 size) {
+    const u64 align = alignof(void*);
+    size = (size + align - 1) & ~(align - 1);
+
+    if ((u64)(bus->cursor_end - bus->cursor) < size && !bus_page_next(bus, size)) {
+        return nullptr;
+    }
+
+    u8* p = bus->cursor;
+    bus->cursor = p + size;
+    return p;
+}
+
+// ===== QUEUE =====
+
+static inline event_entry* bus_event_at(event_bus* bus, u32 idx) {
+    return idx < BUS_MAX_EVENTS_PER_FRAME ? &bus->events[idx] : &bus->overflow[idx - BUS_MAX_EVENTS_PER_FRAME];
+}
+
+// Entry for the next event once the fixed part is full, growing overflow up to the infinite
+// loop guard. Returns nullptr past that or if the allocation fails.
+BUS_NOINLINE static event_entry* bus_overflow_entry(event_bus* bus) {
+    u32 idx = bus->tail - BUS_MAX_EVENTS_PER_FRAME;
+    if (idx == bus->overflow_capacity) {
+        if (bus->tail >= BUS_MAX_EVENTS_PER_PROCESS) {
+            return nullptr;
+        }
+        u32 capacity = bus->overflow_capacity > 0 ? bus->overflow_capacity * 2 : BUS_MAX_EVENTS_PER_FRAME;
+        event_entry* overflow = (event_entry*)qg_realloc(bus->overflow, sizeof(event_entry) * capacity);
+        if (!overflow) {
+            return nullptr;
+        }
+        bus->overflow = overflow;
+        bus->overflow_capacity = capacity;
+    }
+    return &bus->overflow[idx];
+}
 
 void bus_init(event_bus* bus, u64 arena_capacity) {
-    mem_arena_init(&bus->event_arena, arena_capacity);
+    bus->pages = bus_page_create(arena_capacity);
+    bus_page_start(bus, bus->pages);
+    bus->num_pages = 1;
+    bus->payload_bytes = 0;
+    bus->payload_capacity = arena_capacity;
+
+    bus->overflow = nullptr;
+    bus->overflow_capacity = 0;
+    bus->peak_events = 0;
+    bus->peak_payload_bytes = 0;
 
     bus->head = 0;
     bus->tail = 0;
 
-    // Initialize handler arrays
-    for (u32 i = 0; i < (u32)event_type::COUNT; i++) {
-        bus->handler_counts[i] = 0;
-        for (u32 j = 0; j < BUS_MAX_HANDLERS_PER_TYPE; j++) {
-            bus->handlers[i][j].fn = nullptr;
-            bus->handlers[i][j].user_data = nullptr;
-            bus->handlers[i][j].generation = 0;
-            bus->handlers[i][j].active = false;
-        }
+    // No type has a handler list until something subscribes to it
+    memset(bus->type_lists, 0xFF, sizeof(bus->type_lists));
+    bus->num_lists = 0;
+
+    // Nor any subject, their lists are handed out from the top of the stack like slots
+    for (u32 i = 0; i < BUS_SUBJECT_INDEX_SIZE; i++) {
+        bus->subject_index[i].list_idx = BUS_NO_LIST;
+    }
+    for (u32 i = 0; i < BUS_MAX_SUBJECT_LISTS; i++) {
+        bus->free_subject_lists[i] = (u16)(BUS_MAX_LISTS - 1 - i);
+    }
+    bus->num_free_subject_lists = BUS_MAX_SUBJECT_LISTS;
+
+    // Free slots are handed out from the top of the stack, slot 0 first
+    for (u32 i = 0; i < BUS_MAX_HANDLERS; i++) {
+        bus->slots[i].generation = 0;
+        bus->slots[i].type_idx = 0;
+        bus->slots[i].list_idx = BUS_NO_LIST;
+        bus->slots[i].list_pos = BUS_NO_SLOT;
+        bus->free_slots[i] = (u16)(BUS_MAX_HANDLERS - 1 - i);
     }
+    bus->num_free_slots = BUS_MAX_HANDLERS;
+
+    bus->dispatching = false;
+    bus->lists_dirty = false;
+
+    bus->num_channels = 0;
+
+    bus->async = bus_async_create();
+
+    bus->tick = 0;
+    bus->timers = bus_timers_create();
+
+    bus->tap = nullptr;
+    bus->tap_user_data = nullptr;
+
+#if BUS_STATS
+    bus->stats = (bus_stats*)qg_calloc(1, sizeof(bus_stats));
+    bus->stats->budget_queue_events = BUS_BUDGET_QUEUE_EVENTS;
+    bus->stats->budget_payload_bytes = arena_capacity;
+    bus->stats->budget_handler_ns = BUS_BUDGET_HANDLER_NS;
+#endif
 }
 
 void bus_free(event_bus* bus) {
-    mem_arena_clear(&bus->event_arena);
+    for (bus_page* page = bus->pages; page; ) {
+        bus_page* next = page->next;
+        qg_free(page);
+        page = next;
+    }
+    bus->pages = nullptr;
+    bus->page = nullptr;
+    bus->cursor = nullptr;
+    bus->cursor_end = nullptr;
+    bus->num_pages = 0;
+    bus->payload_capacity = 0;
+
+    qg_free(bus->overflow);
+    bus->overflow = nullptr;
+    bus->overflow_capacity = 0;
+
+    void* async_block = bus->async->block;
+    bus->async->~bus_async_queue();
+    qg_free(async_block);
+    bus->async = nullptr;
+
+    qg_free(bus->timers);
+    bus->timers = nullptr;
+
+#if BUS_STATS
+    qg_free(bus->stats);
+    bus->stats = nullptr;
+#endif
 }
 
-handler_id bus_subscribe(event_bus* bus, event_type type, event_handler_fn handler, void* user_data) {
-    u32 type_idx = (u32)type;
+// ===== SUBJECTS =====
 
-    if (type_idx >= (u32)event_type::COUNT) {
-        return INVALID_HANDLER_ID;
+static inline u32 bus_subject_hash(u16 type_idx, u32 subject) {
+    u64 key = ((u64)subject << 16) | type_idx;
+    return (u32)((key * 0x9E3779B97F4A7C15ull) >> 32) & (BUS_SUBJECT_INDEX_SIZE - 1);
+}
+
+// Index entry of a (type, subject) pair, the empty one it would go in if it has none
+static inline bus_subject_entry* bus_subject_find(event_bus* bus, u16 type_idx, u32 subject) {
+    u32 i = bus_subject_hash(type_idx, subject);
+    while (bus->subject_index[i].list_idx != BUS_NO_LIST &&
+           (bus->subject_index[i].subject != subject || bus->subject_index[i].type_idx != type_idx)) {
+        i = (i + 1) & (BUS_SUBJECT_INDEX_SIZE - 1);
     }
+    return &bus->subject_index[i];
+}
 
-    // Find a free slot
-    u32 slot = BUS_MAX_HANDLERS_PER_TYPE;
-    for (u32 i = 0; i < BUS_MAX_HANDLERS_PER_TYPE; i++) {
-        if (!bus->handlers[type_idx][i].active) {
-            slot = i;
-            break;
+// Gives an emptied subject list back. Entries after it in its probe run shift back into
+// the hole, so lookups never need tombstones.
+static void bus_subject_release(event_bus* bus, u16 list_idx) {
+    const u32 mask = BUS_SUBJECT_INDEX_SIZE - 1;
+    u32 hole = 0;
+    while (bus->subject_index[hole].list_idx != list_idx) hole++;
+
+    for (u32 i = (hole + 1) & mask; bus->subject_index[i].list_idx != BUS_NO_LIST; i = (i + 1) & mask) {
+        u32 home = bus_subject_hash(bus->subject_index[i].type_idx, bus->subject_index[i].subject);
+        // Movable when its home isn't in (hole, i], going around the end of the table
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            bus->subject_index[hole] = bus->subject_index[i];
+            hole = i;
         }
     }
+    bus->subject_index[hole].list_idx = BUS_NO_LIST;
+    bus->free_subject_lists[bus->num_free_subject_lists++] = list_idx;
+}
+
+// ===== HANDLERS =====
+
+// Drops entries unsubscribed during dispatch, keeping the others in order
+static void bus_compact_list(event_bus* bus, handler_list* list) {
+    u32 count = 0;
+    for (u32 i = 0; i < list->count; i++) {
+        if (list->slots[i] == BUS_NO_SLOT) continue;
+
+        list->handlers[count] = list->handlers[i];
+        list->slots[count] = list->slots[i];
+        bus->slots[list->slots[count]].list_pos = (u16)count;
+        count++;
+    }
+    list->count = count;
+    list->dirty = false;
+}
+
+static void bus_compact_lists(event_bus* bus) {
+    for (u32 i = 0; i < bus->num_lists; i++) {
+        if (bus->lists[i].dirty) bus_compact_list(bus, &bus->lists[i]);
+    }
+    for (u32 i = BUS_MAX_SUBSCRIBED_TYPES; i < BUS_MAX_LISTS; i++) {
+        if (bus->lists[i].dirty) {
+            bus_compact_list(bus, &bus->lists[i]);
+            if (bus->lists[i].count == 0) bus_subject_release(bus, (u16)i);
+        }
+    }
+    bus->lists_dirty = false;
+}
 
-    if (slot == BUS_MAX_HANDLERS_PER_TYPE) {
+static handler_id bus_add_handler(event_bus* bus, u16 type_idx, u16 list_idx, event_handler_fn handler, void* user_data) {
+    handler_list& list = bus->lists[list_idx];
+    if (list.count == BUS_MAX_HANDLERS_PER_TYPE || bus->num_free_slots == 0) {
         // No free slots
         return INVALID_HANDLER_ID;
     }
 
+    u16 slot_idx = bus->free_slots[--bus->num_free_slots];
+    handler_slot& slot = bus->slots[slot_idx];
+
     // Increment generation for this slot (reuse detection)
-    bus->handlers[type_idx][slot].generation++;
-    u32 generation = bus->handlers[type_idx][slot].generation;
+    slot.generation++;
+    slot.type_idx = type_idx;
+    slot.list_idx = list_idx;
+    slot.list_pos = (u16)list.count;
 
-    bus->handlers[type_idx][slot].fn = handler;
-    bus->handlers[type_idx][slot].user_data = user_data;
-    bus->handlers[type_idx][slot].active = true;
-    bus->handler_counts[type_idx]++;
+    list.handlers[list.count].fn = handler;
+    list.handlers[list.count].user_data = user_data;
+    list.slots[list.count] = slot_idx;
+    list.count++;
 
     // Pack generation, slot, and type into handler_id
     handler_id id;
-    id.generation = generation;
-    id.slot_idx = (u16)slot;
-    id.type_idx = (u16)type_idx;
+    id.generation = slot.generation;
+    id.slot_idx = slot_idx;
+    id.type_idx = type_idx;
+
+    return id;
+}
+
+handler_id bus_subscribe(event_bus* bus, event_type type, event_handler_fn handler, void* user_data) {
+    u32 type_idx = (u32)type;
+
+    if (type_idx >= (u32)event_type::COUNT) {
+        return INVALID_HANDLER_ID;
+    }
+
+    u16 list_idx = bus->type_lists[type_idx];
+    if (list_idx == BUS_NO_LIST) {
+        if (bus->num_lists == BUS_MAX_SUBSCRIBED_TYPES) {
+            // Too many distinct types
+            return INVALID_HANDLER_ID;
+        }
+        list_idx = (u16)bus->num_lists++;
+        bus->type_lists[type_idx] = list_idx;
+        bus->lists[list_idx].count = 0;
+        bus->lists[list_idx].dirty = false;
+    }
+
+    return bus_add_handler(bus, (u16)type_idx, list_idx, handler, user_data);
+}
+
+handler_id bus_subscribe_subject(event_bus* bus, event_type type, u32 subject, event_handler_fn handler, void* user_data) {
+    u32 type_idx = (u32)type;
+
+    if (type_idx >= (u32)event_type::COUNT || subject == BUS_NO_SUBJECT) {
+        return INVALID_HANDLER_ID;
+    }
+
+    bus_subject_entry* entry = bus_subject_find(bus, (u16)type_idx, subject);
+    if (entry->list_idx == BUS_NO_LIST) {
+        if (bus->num_free_subject_lists == 0) {
+            // Too many distinct (type, subject) pairs
+            return INVALID_HANDLER_ID;
+        }
+        u16 list_idx = bus->free_subject_lists[--bus->num_free_subject_lists];
+        bus->lists[list_idx].count = 0;
+        bus->lists[list_idx].dirty = false;
 
+        entry->subject = subject;
+        entry->type_idx = (u16)type_idx;
+        entry->list_idx = list_idx;
+    }
+
+    handler_id id = bus_add_handler(bus, (u16)type_idx, entry->list_idx, handler, user_data);
+    if (id.packed == 0 && bus->lists[entry->list_idx].count == 0) {
+        bus_subject_release(bus, entry->list_idx);
+    }
     return id;
 }
 
@@ -70,98 +779,409 @@ bool bus_unsubscribe(event_bus* bus, handler_id id) {
     u16 type_idx = id.type_idx;
     u16 slot_idx = id.slot_idx;
 
-    if (type_idx >= (u32)event_type::COUNT || slot_idx >= BUS_MAX_HANDLERS_PER_TYPE) {
+    if (type_idx >= (u32)event_type::COUNT || slot_idx >= BUS_MAX_HANDLERS) {
         return false;
     }
 
-    event_handler& handler = bus->handlers[type_idx][slot_idx];
+    handler_slot& slot = bus->slots[slot_idx];
 
     // Check if handler is active and generation matches
-    if (!handler.active || handler.generation != id.generation) {
+    if (slot.list_pos == BUS_NO_SLOT || slot.generation != id.generation || slot.type_idx != type_idx) {
         return false;  // Stale handler_id or already unsubscribed
     }
 
-    // Deactivate the handler
-    handler.active = false;
-    handler.fn = nullptr;
-    handler.user_data = nullptr;
+    handler_list& list = bus->lists[slot.list_idx];
+    if (bus->dispatching) {
+        // Handlers may be running over this list right now, so entries only move once they're done
+        list.slots[slot.list_pos] = BUS_NO_SLOT;
+        list.handlers[slot.list_pos].fn = nullptr;
+        list.handlers[slot.list_pos].user_data = nullptr;
+        list.dirty = true;
+        bus->lists_dirty = true;
+    } else {
+        // Close the gap, keeping subscription order
+        list.count--;
+        for (u32 i = slot.list_pos; i < list.count; i++) {
+            list.handlers[i] = list.handlers[i + 1];
+            list.slots[i] = list.slots[i + 1];
+            bus->slots[list.slots[i]].list_pos = (u16)i;
+        }
+        if (list.count == 0 && slot.list_idx >= BUS_MAX_SUBSCRIBED_TYPES) {
+            bus_subject_release(bus, slot.list_idx);
+        }
+    }
+
     // Note: we don't reset generation - it stays incremented for next reuse
-    bus->handler_counts[type_idx]--;
+    slot.list_pos = BUS_NO_SLOT;
+    bus->free_slots[bus->num_free_slots++] = slot_idx;
 
     return true;
 }
 
-bool bus_fire(event_bus* bus, event_type type, const void* data, u32 data_size) {
-    // Check if ring buffer is full
-    u32 num_events = bus->tail - bus->head;
-    if (num_events >= BUS_MAX_EVENTS_PER_FRAME) {
-        // Ring buffer full
+static inline bool bus_enqueue(event_bus* bus, event_type type, u32 subject, const void* data, u32 data_size) {
+    event_entry* entry = bus->tail < BUS_MAX_EVENTS_PER_FRAME ? &bus->events[bus->tail] : bus_overflow_entry(bus);
+    if (entry == nullptr) {
+#if BUS_STATS
+        bus_stats_drop(bus, type, BUS_DROP_QUEUE_FULL);
+#endif
         return false;
     }
 
-    // Allocate space in arena for event data
-    arena_ptr event_data = mem_arena_alloc(&bus->event_arena, data_size, alignof(void*));
-
-    if (event_data.p == nullptr) {
-        // Arena is full
+    u8* event_data = bus_page_alloc(bus, data_size);
+    if (event_data == nullptr) {
+#if BUS_STATS
+        bus_stats_drop(bus, type, BUS_DROP_PAGE_FAILED);
+#endif
         return false;
     }
 
-    // Copy event data into arena
+    // Copy event data into the page
     if (data && data_size > 0) {
-        memcpy(event_data.p, data, data_size);
+        memcpy(event_data, data, data_size);
     }
 
-    // Add event to ring buffer using power-of-2 masking
-    u32 idx = bus->tail & BUS_EVENT_MASK;
-    event_entry& entry = bus->events[idx];
-    entry.type = type;
-    entry.data = event_data;
-    entry.data_size = data_size;
+    entry->type = type;
+    entry->subject = subject;
+    entry->data = event_data;
+    entry->data_size = data_size;
 
     bus->tail++;
 
+#if BUS_STATS
+    if (bus_type_stats* ts = bus_stats_type(bus, type)) {
+        ts->fired++;
+        ts->bytes += data_size;
+    }
+    if (bus->tail - bus->head > bus->stats->queue_high_water) {
+        bus->stats->queue_high_water = bus->tail - bus->head;
+    }
+#endif
+
     return true;
 }
 
-void bus_process(event_bus* bus) {
-    u32 events_processed = 0;
+bool bus_fire(event_bus* bus, event_type type, const void* data, u32 data_size) {
+    return bus_enqueue(bus, type, BUS_NO_SUBJECT, data, data_size);
+}
+
+bool bus_fire_subject(event_bus* bus, event_type type, u32 subject, const void* data, u32 data_size) {
+    return bus_enqueue(bus, type, subject, data, data_size);
+}
+
+bool bus_fire_async(event_bus* bus, event_type type, const void* data, u32 data_size) {
+    bus_async_queue* q = bus->async;
+    bus_async_producer* p = &t_producer;
+
+    u32 size = (data_size + alignof(void*) - 1) & ~(u32)(alignof(void*) - 1);
+    if (size > BUS_ASYNC_CHUNK_SIZE) {
+        bus_async_dropped(q);
+        return false;
+    }
+
+    // A chunk from a bus that has since been freed went away with it. (One from a different
+    // live bus stays taken: threads release before switching buses.)
+    if (p->epoch != q->epoch) {
+        p->epoch = 0;
+    }
+
+    if (p->epoch == 0 || p->used + size > BUS_ASYNC_CHUNK_SIZE) {
+        u32 idx = bus_chunk_pop(q);
+        if (idx == BUS_ASYNC_NO_CHUNK) {
+            // Every chunk is in use
+            bus_async_dropped(q);
+            return false;
+        }
+        q->chunks[idx].refs.store(1, std::memory_order_relaxed);
+
+        if (p->epoch != 0) {
+            bus_chunk_release(q, p->chunk);
+        }
+        p->epoch = q->epoch;
+        p->chunk = idx;
+        p->used = 0;
+    }
+
+    // Claim a ticket
+    u32 pos = q->enqueue_pos.load(std::memory_order_relaxed);
+    bus_async_cell* cell;
+    for (;;) {
+        cell = &q->cells[pos & BUS_ASYNC_MASK];
+        i32 diff = (i32)(cell->sequence.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (q->enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Ring full, the main thread hasn't drained this cell yet
+            bus_async_dropped(q);
+            return false;
+        } else {
+            pos = q->enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    bus_async_chunk& chunk = q->chunks[p->chunk];
+    u8* dst = chunk.data + p->used;
+    if (data && data_size > 0) {
+        memcpy(dst, data, data_size);
+    }
+    p->used += size;
+    chunk.refs.fetch_add(1, std::memory_order_relaxed);
+
+    cell->type = type;
+    cell->data_size = data_size;
+    cell->chunk = p->chunk;
+    cell->data = dst;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+void bus_async_release(event_bus* bus) {
+    bus_async_producer* p = &t_producer;
+    if (p->epoch != 0 && p->epoch == bus->async->epoch) {
+        bus_chunk_release(bus->async, p->chunk);
+    }
+    p->epoch = 0;
+}
+
+timer_id bus_fire_at(event_bus* bus, u64 tick, event_type type, const void* data, u32 data_size) {
+    bus_timer_wheel* w = bus->timers;
+    if (data_size > BUS_TIMER_MAX_DATA || w->free_head == BUS_NO_TIMER) {
+#if BUS_STATS
+        bus_stats_drop(bus, type, BUS_DROP_TIMERS_FULL);
+#endif
+        return INVALID_TIMER_ID;
+    }
+
+    u16 idx = w->free_head;
+    bus_timer& t = w->timers[idx];
+    w->free_head = t.next;
+    w->count++;
+
+    // Increment generation for this timer (reuse detection)
+    t.generation++;
+
+    t.due = tick > bus->tick ? tick : bus->tick + 1;
+    t.type = type;
+    t.data_size = data_size;
+    if (data_size > 0) {
+        memcpy(t.data, data, data_size);
+    }
+    bus_timer_link(w, idx, bus_timer_list_for(t.due, bus->tick));
+
+    timer_id id;
+    id.generation = t.generation;
+    id.timer_idx = idx;
+    id.reserved = 0;
+    return id;
+}
+
+timer_id bus_fire_after(event_bus* bus, u64 ticks, event_type type, const void* data, u32 data_size) {
+    return bus_fire_at(bus, bus->tick + (ticks > 0 ? ticks : 1), type, data, data_size);
+}
+
+bool bus_cancel_timer(event_bus* bus, timer_id id) {
+    bus_timer_wheel* w = bus->timers;
+    if (id.timer_idx >= BUS_MAX_TIMERS) {
+        return false;
+    }
+
+    bus_timer& t = w->timers[id.timer_idx];
+    if (t.list == BUS_NO_TIMER || t.generation != id.generation) {
+        return false;
+    }
+
+    bus_timer_unlink(w, id.timer_idx);
+    bus_timer_release(w, id.timer_idx);
+    return true;
+}
+
+bool bus_add_channel(event_bus* bus, bus_channel_base* channel) {
+    if (bus->num_channels == BUS_MAX_CHANNELS) {
+        return false;
+    }
+    for (u32 i = 0; i < bus->num_channels; i++) {
+        if (bus->channels[i] == channel || bus->channels[i]->type == channel->type) {
+            // One channel per event type
+            return false;
+        }
+    }
+
+    bus->channels[bus->num_channels++] = channel;
+    return true;
+}
+
+bool bus_remove_channel(event_bus* bus, bus_channel_base* channel) {
+    for (u32 i = 0; i < bus->num_channels; i++) {
+        if (bus->channels[i] == channel) {
+            // Keep the flush order of the others
+            memmove(&bus->channels[i], &bus->channels[i + 1], sizeof(bus_channel_base*) * (bus->num_channels - i - 1));
+            bus->num_channels--;
+            return true;
+        }
+    }
+    return false;
+}
+
+u64 bus_payload_bytes(event_bus* bus) {
+    return bus_payload_used(bus);
+}
+
+void bus_set_tap(event_bus* bus, bus_tap_fn tap, void* user_data) {
+    bus->tap = tap;
+    bus->tap_user_data = user_data;
+}
 
-    // Process events until head catches up with tail
+static bool bus_channels_pending(event_bus* bus) {
+    for (u32 i = 0; i < bus->num_channels; i++) {
+        if (bus->channels[i]->count > 0) return true;
+    }
+    return false;
+}
+
+// Channel events go to the tap one at a time, in the order the batch has them
+static void bus_tap_channel(event_bus* bus, bus_channel_base* channel) {
+    const u8* data = (const u8*)channel->event_data;
+    for (u32 i = 0; i < channel->count; i++) {
+        bus->tap(channel->type, BUS_NO_SUBJECT, data + (u64)i * channel->event_size, channel->event_size, bus->tap_user_data);
+    }
+}
+
+// Calls the live handlers of a list. The count is re-read every iteration, so handlers
+// subscribed by a handler also see this event.
+static inline void bus_dispatch_list(event_bus* bus, handler_list& list, const event_entry& evt) {
+    bus->dispatching = true;
+    for (u32 j = 0; j < list.count; j++) {
+        event_handler& handler = list.handlers[j];
+        if (handler.fn) {
+#if BUS_STATS
+            u64 start = bus_stats_now_ns();
+            handler.fn(evt.type, evt.data, handler.user_data);
+            bus_stats_handler(bus, evt.type, bus_stats_now_ns() - start);
+#else
+            handler.fn(evt.type, evt.data, handler.user_data);
+#endif
+        }
+    }
+    bus->dispatching = false;
+}
+
+// Dispatches queued events until head catches up with tail
+static void bus_dispatch_queue(event_bus* bus, u32* events_processed) {
     // Handlers can fire new events which will extend tail
     while (bus->head < bus->tail) {
         // Safety check to prevent infinite loops
-        if (events_processed >= BUS_MAX_EVENTS_PER_PROCESS) {
-            // TODO: Log error or assert - infinite event loop detected
+        if (*events_processed >= BUS_MAX_EVENTS_PER_PROCESS) {
+            // Whatever is left gets dropped by bus_reset, counted as a truncation in debug builds
             break;
         }
 
-        // Get event using power-of-2 masking
-        u32 idx = bus->head & BUS_EVENT_MASK;
-        event_entry& evt = bus->events[idx];
+        // By value: handlers firing events can grow (move) overflow
+        event_entry evt = *bus_event_at(bus, bus->head);
 
-        u16 type_idx = (u16)evt.type;
+        if (bus->tap) {
+            bus->tap(evt.type, evt.subject, evt.data, evt.data_size, bus->tap_user_data);
+        }
 
+        u16 type_idx = (u16)evt.type;
         if (type_idx < (u32)event_type::COUNT) {
-            // Call all active handlers for this event type
-            for (u32 j = 0; j < BUS_MAX_HANDLERS_PER_TYPE; j++) {
-                event_handler& handler = bus->handlers[type_idx][j];
-                if (handler.active && handler.fn) {
-                    handler.fn(evt.type, evt.data.p, handler.user_data);
+            u16 list_idx = bus->type_lists[type_idx];
+            if (list_idx != BUS_NO_LIST) {
+                bus_dispatch_list(bus, bus->lists[list_idx], evt);
+            }
+
+            // Looked up after the type's handlers ran, they may have subscribed to the subject
+            if (evt.subject != BUS_NO_SUBJECT) {
+                bus_subject_entry* entry = bus_subject_find(bus, type_idx, evt.subject);
+                if (entry->list_idx != BUS_NO_LIST) {
+                    bus_dispatch_list(bus, bus->lists[entry->list_idx], evt);
                 }
             }
+
+            if (bus->lists_dirty) {
+                bus_compact_lists(bus);
+            }
+        }
+
+#if BUS_STATS
+        if (bus_type_stats* ts = bus_stats_type(bus, evt.type)) {
+            ts->dispatched++;
         }
+#endif
 
         bus->head++;
-        events_processed++;
+        (*events_processed)++;
     }
+}
+
+void bus_process(event_bus* bus) {
+    u32 events_processed = 0;
+
+    bus_async_drain(bus);
+
+    bus->tick++;
+    bus_timers_advance(bus);
+
+    // Channels first, each as one batch per handler, then the queue. Either side can fire
+    // into the other, so go around again while channels have something new; anything still
+    // in a channel after the last pass waits for the next bus_process.
+    for (u32 pass = 0; pass < BUS_MAX_CHANNEL_PASSES; pass++) {
+        for (u32 i = 0; i < bus->num_channels; i++) {
+            bus_channel_base* channel = bus->channels[i];
+            if (channel->count > 0) {
+                if (bus->tap) {
+                    bus_tap_channel(bus, channel);
+                }
+#if BUS_STATS
+                u32 count = channel->count;
+                u64 start = bus_stats_now_ns();
+                channel->flush(channel);
+                bus_stats_handler(bus, channel->type, bus_stats_now_ns() - start);
+                if (bus_type_stats* ts = bus_stats_type(bus, channel->type)) {
+                    ts->fired += count;
+                    ts->dispatched += count;
+                }
+#else
+                channel->flush(channel);
+#endif
+            }
+        }
+
+        bus_dispatch_queue(bus, &events_processed);
+
+        if (!bus_channels_pending(bus)) {
+            break;
+        }
+    }
+
+#if BUS_STATS
+    u32 queued = bus->tail;
+    u64 payload_bytes = bus_payload_used(bus);
+    u32 undispatched = bus->tail - bus->head;
+#endif
 
     // Clear events for next frame
     bus_reset(bus);
+
+#if BUS_STATS
+    bus_stats_end_process(bus, queued, payload_bytes, undispatched);
+#endif
 }
 
 void bus_reset(event_bus* bus) {
+    if (bus->tail > bus->peak_events) {
+        bus->peak_events = bus->tail;
+    }
+    u64 payload_bytes = bus_payload_used(bus);
+    if (payload_bytes > bus->peak_payload_bytes) {
+        bus->peak_payload_bytes = payload_bytes;
+    }
+
     bus->head = 0;
     bus->tail = 0;
-    mem_arena_reset(&bus->event_arena);
+
+    // Keep every page for the next frames
+    bus_page_start(bus, bus->pages);
+    bus->payload_bytes = 0;
 }
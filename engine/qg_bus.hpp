@@ -2,6 +2,9 @@
 #include "shared_types.hpp"
 #include "qg_memory.hpp"
 
+#include <cstring>
+#include <type_traits>
+
 // Define your event types here
 enum class event_type : u16 {
     NONE = 0,
@@ -46,10 +49,14 @@ struct perf_frame_stats_event {
     f32 fps;
 };
 
+// One per tracked arena each second, plus "heap" for the qg_malloc totals and "bus" for the
+// event payload pages (see mem_arena_track)
 struct perf_memory_stats_event {
+    char name[24];
     u64 used_bytes;
     u64 peak_bytes;
-    u64 capacity_bytes;
+    u64 capacity_bytes;     // 0 for the heap
+    u64 num_allocs;
 };
 
 struct perf_budget_exceeded_event {
@@ -96,7 +103,7 @@ struct handler_id {
         u64 packed;
         struct {
             u32 generation;  // Must match slot's generation to be valid
-            u16 slot_idx;    // Which slot in the handlers array
+            u16 slot_idx;    // Index into event_bus::slots
             u16 type_idx;    // Event type index
         };
     };
@@ -104,41 +111,235 @@ struct handler_id {
 
 #define INVALID_HANDLER_ID (handler_id{0})
 
-#define BUS_MAX_HANDLERS_PER_TYPE 16
-#define BUS_MAX_EVENTS_PER_FRAME 512  // Must be power of 2!
-#define BUS_EVENT_MASK (BUS_MAX_EVENTS_PER_FRAME - 1)
+// Timer ID for a scheduled event: generation-checked like handler_id
+struct timer_id {
+    union {
+        u64 packed;
+        struct {
+            u32 generation;  // Must match the timer's generation to be valid
+            u16 timer_idx;   // Which timer in the wheel's pool
+            u16 reserved;
+        };
+    };
+};
+
+#define INVALID_TIMER_ID (timer_id{0})
+
+#define BUS_MAX_HANDLERS_PER_TYPE 16  // Per type, and per (type, subject) on top of that
+#define BUS_MAX_HANDLERS 256          // Live subscriptions across all event types
+#define BUS_MAX_SUBSCRIBED_TYPES 64   // Distinct event types that can have handlers
+#define BUS_MAX_SUBJECT_LISTS 64      // Distinct (type, subject) pairs that can have handlers
+#define BUS_SUBJECT_INDEX_SIZE 128    // Must be power of 2, at least twice BUS_MAX_SUBJECT_LISTS
+#define BUS_MAX_LISTS (BUS_MAX_SUBSCRIBED_TYPES + BUS_MAX_SUBJECT_LISTS)
+#define BUS_MAX_EVENTS_PER_FRAME 512  // Soft limit, a frame that fires more grows the queue
+#define BUS_PAGE_SIZE (64 * 1024)     // Payload pages added past bus_init's first one
+
+#define BUS_ASYNC_RING_SIZE 1024      // Must be power of 2!
+#define BUS_ASYNC_MASK (BUS_ASYNC_RING_SIZE - 1)
+#define BUS_ASYNC_CHUNK_SIZE (16 * 1024)
+#define BUS_ASYNC_NUM_CHUNKS 32
+
+#define BUS_MAX_CHANNELS 32
+#define BUS_MAX_CHANNEL_PASSES 4      // Channel flush + queue rounds per bus_process
+#define BUS_CHANNEL_MAX_HANDLERS 8
+#define BUS_CHANNEL_DEFAULT_CAPACITY 64
 
-// Safety limit to prevent infinite event loops
-#define BUS_MAX_EVENTS_PER_PROCESS (BUS_MAX_EVENTS_PER_FRAME * 2)
+#define BUS_MAX_TIMERS 1024           // Scheduled events pending at once
+#define BUS_TIMER_MAX_DATA 64         // Scheduled payloads are kept inline until they fire
+
+#define BUS_NO_LIST 0xFFFF
+#define BUS_NO_SLOT 0xFFFF
+#define BUS_NO_SUBJECT 0xFFFFFFFFu    // Subject of events fired without one
+
+// Safety limit to prevent infinite event loops, also the most events the queue grows to
+#define BUS_MAX_EVENTS_PER_PROCESS (BUS_MAX_EVENTS_PER_FRAME * 64)
 
 struct event_entry {
     event_type type;
-    arena_ptr data;
+    u32 subject;     // BUS_NO_SUBJECT unless fired with bus_fire_subject
+    void* data;
     u32 data_size;
 };
 
+// One block of payload memory, data follows the header
+struct bus_page {
+    bus_page* next;
+    u64 capacity;
+};
+
 struct event_handler {
     event_handler_fn fn;
     void* user_data;
+};
+
+// Live handlers of one event type, or of one (type, subject) pair, packed in subscription
+// order. Dispatch walks handlers[0, count) and nothing else.
+struct handler_list {
+    event_handler handlers[BUS_MAX_HANDLERS_PER_TYPE];
+    u16 slots[BUS_MAX_HANDLERS_PER_TYPE];   // Owning handler_slot, BUS_NO_SLOT if unsubscribed mid-dispatch
+    u32 count;
+    bool dirty;                             // Has BUS_NO_SLOT entries waiting to be compacted
+};
+
+// Stable identity behind a handler_id, while the handler itself moves within its list
+struct handler_slot {
     u32 generation;  // Incremented each time this slot is reused
-    bool active;
+    u16 type_idx;
+    u16 list_idx;    // The handler_list it's in, the type's own or a subject's
+    u16 list_pos;    // Index in that handler_list, BUS_NO_SLOT when the slot is free
+};
+
+// Open-addressed (type, subject) -> handler_list, for the subscriptions keyed on a subject
+struct bus_subject_entry {
+    u32 subject;
+    u16 type_idx;
+    u16 list_idx;    // BUS_NO_LIST = empty
+};
+
+// Called by bus_process with each event it dispatches, queue and channels alike
+typedef void (*bus_tap_fn)(event_type type, u32 subject, const void* data, u32 data_size, void* user_data);
+
+// Type-erased side of a bus_channel<T>, what the bus keeps and flushes
+struct bus_channel_base {
+    event_type type;
+    u32 count;                                // Events fired since the last flush
+    const void* event_data;                   // The pending events, count of event_size bytes each
+    u32 event_size;
+    void (*flush)(bus_channel_base* channel); // Set by channel_init for the concrete T
 };
 
+// Cross-thread queue and payload chunks, defined in qg_bus.cpp
+struct bus_async_queue;
+
+// Scheduled events, defined in qg_bus.cpp
+struct bus_timer_wheel;
+
+// ===== INSTRUMENTATION =====
+// Debug builds count what goes through the bus in event_bus::stats and fire PERF_BUDGET_EXCEEDED
+// when a bus_process goes over one of the budgets below. Defining NDEBUG compiles all of it
+// out, event_bus::stats included; -DBUS_STATS=0/1 overrides that either way. The engine and
+// the game have to agree on it since they share the event_bus layout.
+#ifndef BUS_STATS
+#ifdef NDEBUG
+#define BUS_STATS 0
+#else
+#define BUS_STATS 1
+#endif
+#endif
+
+#if BUS_STATS
+#define BUS_STATS_HISTOGRAM_BUCKETS 16  // Handler call times: bucket 0 is < 128 ns, each next one doubles, the last takes the rest
+
+// Defaults for the bus_stats budgets
+#define BUS_BUDGET_QUEUE_EVENTS (BUS_MAX_EVENTS_PER_FRAME * 3 / 4)
+#define BUS_BUDGET_HANDLER_NS (1000 * 1000)
+
+enum bus_drop_reason {
+    BUS_DROP_QUEUE_FULL,    // bus_fire: the frame queue was full
+    BUS_DROP_PAGE_FAILED,   // bus_fire: couldn't allocate a payload page
+    BUS_DROP_ASYNC,         // bus_fire_async: ring full, no free chunk or payload too large (not per type)
+    BUS_DROP_TIMERS_FULL,   // bus_fire_at: no free timer or payload too large
+    BUS_DROP_COUNT
+};
+
+struct bus_type_stats {
+    u64 fired;          // Queued with bus_fire (async and timer events count once they reach the queue), or through a channel
+    u64 dispatched;     // Events handed to handlers, a channel batch counts each event
+    u64 bytes;          // Payload bytes copied into the bus pages
+    u64 dropped;        // Fires of this type refused, all reasons
+    u64 handler_calls;  // A channel flush counts as one call
+    u64 handler_ns;
+    u64 handler_max_ns;
+    u32 handler_histogram[BUS_STATS_HISTOGRAM_BUCKETS];
+};
+
+struct bus_stats {
+    bus_type_stats types[(u32)event_type::COUNT];
+
+    u64 processes;
+    u32 queue_high_water;       // Most events waiting in the queue at once
+    u64 drops[BUS_DROP_COUNT];
+    u64 truncated_processes;    // bus_process calls that stopped at BUS_MAX_EVENTS_PER_PROCESS
+    u64 truncated_events;       // Events those calls left undispatched
+    u64 budget_events;          // PERF_BUDGET_EXCEEDED fired by the bus
+
+    // Budgets per bus_process, 0 turns one off. Going over fires PERF_BUDGET_EXCEEDED, which
+    // handlers get in the next bus_process; drops and truncations always fire it.
+    u32 budget_queue_events;    // Events queued in one bus_process
+    u64 budget_payload_bytes;   // Payload bytes used in one bus_process
+    u64 budget_handler_ns;      // Time spent in a single handler call
+
+    // The bus_process in progress
+    u64 frame_drops;
+    u64 frame_max_handler_ns;
+};
+#endif
+
 struct event_bus {
-    // Ring buffer for event queue
+    // Event queue for the frame: the first BUS_MAX_EVENTS_PER_FRAME events go here, a busier
+    // frame carries on into overflow, which doubles when full and is kept for later frames
     event_entry events[BUS_MAX_EVENTS_PER_FRAME];
     u32 head;  // Next event to process
     u32 tail;  // Next free slot
-
-    // Handlers registered for each event type
-    event_handler handlers[(u32)event_type::COUNT][BUS_MAX_HANDLERS_PER_TYPE];
-    u32 handler_counts[(u32)event_type::COUNT];
-
-    // Memory for event data
-    mem_arena event_arena;
+    event_entry* overflow;
+    u32 overflow_capacity;
+
+    // Memory for event data: pages filled front to back, rewound by bus_reset and kept, so
+    // frames stop allocating once the chain fits the busiest one
+    bus_page* pages;            // First page, bus_init's arena_capacity bytes
+    bus_page* page;             // Page being filled, pages after it are unused this frame
+    u8* cursor;                 // Next free byte in page
+    u8* cursor_end;
+    u32 num_pages;
+    u64 payload_bytes;          // Used this frame in the pages before page
+    u64 payload_capacity;       // All pages together
+
+    // Busiest frame so far
+    u32 peak_events;
+    u64 peak_payload_bytes;
+
+    // Event type -> handler list, assigned on the first subscription to the type. Lists
+    // [0, BUS_MAX_SUBSCRIBED_TYPES) are the types' own, the rest belong to subjects.
+    u16 type_lists[(u32)event_type::COUNT];
+    handler_list lists[BUS_MAX_LISTS];
+    u32 num_lists;
+
+    // (type, subject) -> handler list. A subject's list goes back on the free stack once
+    // its last handler unsubscribes, so subjects can come and go (entities, matches)
+    bus_subject_entry subject_index[BUS_SUBJECT_INDEX_SIZE];
+    u16 free_subject_lists[BUS_MAX_SUBJECT_LISTS];
+    u32 num_free_subject_lists;
+
+    // handler_id slots, shared by all types
+    handler_slot slots[BUS_MAX_HANDLERS];
+    u16 free_slots[BUS_MAX_HANDLERS];
+    u32 num_free_slots;
+
+    // Unsubscribing while handlers run only marks the entry, lists are compacted after the event
+    bool dispatching;
+    bool lists_dirty;
+
+    // Typed channels, flushed in the order they were added
+    bus_channel_base* channels[BUS_MAX_CHANNELS];
+    u32 num_channels;
+
+    // Events fired from other threads, drained at the start of bus_process
+    bus_async_queue* async;
+
+    // Number of bus_process calls so far, one per fixed-timestep tick in qg_main
+    u64 tick;
+    bus_timer_wheel* timers;
+
+    // Sees every event bus_process dispatches, before its handlers do (see bus_set_tap)
+    bus_tap_fn tap;
+    void* tap_user_data;
+
+#if BUS_STATS
+    bus_stats* stats;
+#endif
 };
 
-// Initialize the event bus with arena capacity
+// Initialize the event bus, arena_capacity is the size of the first payload page
 void bus_init(event_bus* bus, u64 arena_capacity);
 
 // Cleanup
@@ -148,24 +349,172 @@ void bus_free(event_bus* bus);
 // Returns handler_id that can be used to unsubscribe
 handler_id bus_subscribe(event_bus* bus, event_type type, event_handler_fn handler, void* user_data = nullptr);
 
+// Subscribe to the events of a type fired for one subject (a player, a match, an entity...)
+// with bus_fire_subject. The bus looks the subject's handlers up instead of calling every
+// handler of the type, so they don't have to filter. Handlers from bus_subscribe still see
+// every event of the type, subject or not; these ones only their subject's.
+handler_id bus_subscribe_subject(event_bus* bus, event_type type, u32 subject, event_handler_fn handler, void* user_data = nullptr);
+
 // Unsubscribe a handler (type and slot are encoded in handler_id)
 // Returns true if successfully unsubscribed, false if handler_id is invalid or stale
 bool bus_unsubscribe(event_bus* bus, handler_id id);
 
-// Fire an event (copies data into arena)
-// Returns true on success, false if queue or arena is full
+// Fire an event (copies data into the bus pages, adding a page if needed)
+// Returns true on success, false past BUS_MAX_EVENTS_PER_PROCESS events or if a page can't be allocated
 // Can be called from event handlers - new events will be processed in the same frame
 bool bus_fire(event_bus* bus, event_type type, const void* data, u32 data_size);
 
+// Fire an event for a subject: the type's bus_subscribe handlers, then that subject's
+// bus_subscribe_subject handlers. Timers, channels and bus_fire_async events have no subject.
+bool bus_fire_subject(event_bus* bus, event_type type, u32 subject, const void* data, u32 data_size);
+
+// Fire an event from any thread (copies data into a payload chunk owned by the calling thread)
+// Returns false if the cross-thread queue is full or no chunk is free; nothing is queued then
+// bus_process drains these after the events already queued with bus_fire, in the order the
+// fires completed, so each thread's own events keep the order it fired them in
+bool bus_fire_async(event_bus* bus, event_type type, const void* data, u32 data_size);
+
+// Hand the calling thread's payload chunk back to the bus
+// Producer threads should call this before they exit or fire into another bus, otherwise the
+// chunk stays taken until bus_free
+void bus_async_release(event_bus* bus);
+
+// Schedule an event for the bus_process that brings bus->tick to `tick` (copies data, up to
+// BUS_TIMER_MAX_DATA bytes). A tick that has already been processed means the next bus_process.
+// Due events are queued after the events fired during that tick, in the order they were scheduled
+// Returns INVALID_TIMER_ID if BUS_MAX_TIMERS are pending or data is too large
+timer_id bus_fire_at(event_bus* bus, u64 tick, event_type type, const void* data, u32 data_size);
+
+// Schedule an event `ticks` bus_process calls from now (0 behaves like 1)
+timer_id bus_fire_after(event_bus* bus, u64 ticks, event_type type, const void* data, u32 data_size);
+
+// Cancel a scheduled event that hasn't fired yet
+// Returns false if the timer_id is stale, already fired or already cancelled
+bool bus_cancel_timer(event_bus* bus, timer_id id);
+
 // Macro helper for type-safe event firing
 // Usage: bus_fire_event(&bus, event_type::PLAYER_DAMAGED, my_event_struct)
 #define bus_fire_event(bus, type, event_data) \
     g_eng.bus_fire(bus, type, &(event_data), sizeof(event_data))
 
+#define bus_fire_subject_event(bus, type, subject, event_data) \
+    g_eng.bus_fire_subject(bus, type, subject, &(event_data), sizeof(event_data))
+
 // Process all queued events and dispatch to handlers
 // Call this at the end of each frame
 // Handles recursive events - events fired during processing will be handled in the same frame
 void bus_process(event_bus* bus);
 
-// Clear all events and reset arena (called automatically by bus_process)
+// Clear all events and rewind the pages (called automatically by bus_process)
 void bus_reset(event_bus* bus);
+
+// Register a typed channel so bus_process flushes it, one channel per event type
+// Returns false if the type already has a channel or BUS_MAX_CHANNELS is reached
+bool bus_add_channel(event_bus* bus, bus_channel_base* channel);
+
+// Stop flushing a channel (its pending events stay in it), not from inside bus_process
+bool bus_remove_channel(event_bus* bus, bus_channel_base* channel);
+
+// Engine only (the replay recorder): tap sees each dispatched event, nullptr removes it
+void bus_set_tap(event_bus* bus, bus_tap_fn tap, void* user_data = nullptr);
+
+// Engine only: payload bytes of the events queued right now
+u64 bus_payload_bytes(event_bus* bus);
+
+#if BUS_STATS
+// Zero the counters and keep the budgets
+void bus_stats_reset(event_bus* bus);
+
+// Totals, then one line per event type that saw any traffic
+void bus_stats_print(event_bus* bus);
+#endif
+
+// ===== TYPED CHANNELS =====
+// For frequent events of one struct type: fires copy the struct by value into the channel's
+// own array, and bus_process calls each handler once with every event of the type fired
+// since the last flush, in firing order. Channels live wherever the owner puts them (game
+// state, a static) and are flushed before the regular queue.
+//
+// Usage:
+//   bus_channel<level_gravity_changed_event> gravity_changed;
+//   channel_init(&gravity_changed, (event_type)game_event_type::LEVEL_GRAVITY_CHANGED);
+//   channel_subscribe(&gravity_changed, on_gravity_changed, nullptr);
+//   g_api.bus_add_channel(g_api.bus, &gravity_changed);
+//   channel_fire(&gravity_changed, e);
+
+template<class T, u32 N = BUS_CHANNEL_DEFAULT_CAPACITY>
+struct bus_channel : bus_channel_base {
+    typedef void (*handler_fn)(const T* events, u32 count, void* user_data);
+
+    T events[N];
+    handler_fn handlers[BUS_CHANNEL_MAX_HANDLERS];
+    void* user_data[BUS_CHANNEL_MAX_HANDLERS];
+    u32 num_handlers;
+};
+
+template<class T, u32 N>
+static void channel_flush(bus_channel_base* base) {
+    bus_channel<T, N>* ch = static_cast<bus_channel<T, N>*>(base);
+
+    u32 count = ch->count;
+    for (u32 i = 0; i < ch->num_handlers; i++) {
+        ch->handlers[i](ch->events, count, ch->user_data[i]);
+    }
+
+    // Events the handlers fired into this channel landed after the batch, they go next pass
+    u32 extra = ch->count - count;
+    if (extra > 0) {
+        memmove(ch->events, ch->events + count, sizeof(T) * extra);
+    }
+    ch->count = extra;
+}
+
+template<class T, u32 N>
+void channel_init(bus_channel<T, N>* ch, event_type type) {
+    static_assert(std::is_trivially_copyable<T>::value, "Channel events are copied as raw bytes");
+
+    ch->type = type;
+    ch->count = 0;
+    ch->event_data = ch->events;
+    ch->event_size = sizeof(T);
+    ch->flush = channel_flush<T, N>;
+    ch->num_handlers = 0;
+}
+
+// Returns false if the channel already has BUS_CHANNEL_MAX_HANDLERS handlers
+template<class T, u32 N>
+bool channel_subscribe(bus_channel<T, N>* ch, typename bus_channel<T, N>::handler_fn fn, void* user_data = nullptr) {
+    if (ch->num_handlers == BUS_CHANNEL_MAX_HANDLERS) {
+        return false;
+    }
+    ch->handlers[ch->num_handlers] = fn;
+    ch->user_data[ch->num_handlers] = user_data;
+    ch->num_handlers++;
+    return true;
+}
+
+// Not from inside one of this channel's handlers
+template<class T, u32 N>
+bool channel_unsubscribe(bus_channel<T, N>* ch, typename bus_channel<T, N>::handler_fn fn, void* user_data = nullptr) {
+    for (u32 i = 0; i < ch->num_handlers; i++) {
+        if (ch->handlers[i] == fn && ch->user_data[i] == user_data) {
+            for (u32 j = i + 1; j < ch->num_handlers; j++) {
+                ch->handlers[j - 1] = ch->handlers[j];
+                ch->user_data[j - 1] = ch->user_data[j];
+            }
+            ch->num_handlers--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns false if the channel is full until the next flush
+template<class T, u32 N>
+inline bool channel_fire(bus_channel<T, N>* ch, const T& event) {
+    if (ch->count == N) {
+        return false;
+    }
+    ch->events[ch->count++] = event;
+    return true;
+}
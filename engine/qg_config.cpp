@@ -9,6 +9,7 @@
 
 void config_init(config *c, const char *file) {
     mem_arena_init(&c->_mem_vals, CONFIG_ALLOC_SIZE);
+    mem_arena_track(&c->_mem_vals, "config");
 
     u64 file_size = 0;
     char *content = (char *)SDL_LoadFile(file, &file_size);
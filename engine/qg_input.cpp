@@ -5,7 +5,7 @@
 #include <cassert>
 
 static const i32 g_keycode_map[(u16)key_code::COUNT] = {
-    SDLK_W, SDLK_A, SDLK_S, SDLK_D, SDLK_R,
+    SDLK_W, SDLK_A, SDLK_S, SDLK_D, SDLK_R, SDLK_H,
     SDLK_UP, SDLK_DOWN, SDLK_LEFT, SDLK_RIGHT,
     SDLK_RETURN, SDLK_SPACE, SDLK_ESCAPE,
     SDLK_PAGEUP, SDLK_PAGEDOWN,
@@ -2,7 +2,7 @@
 #include "shared_types.hpp"
 
 enum class key_code : u16 {
-    W, A, S, D, R,
+    W, A, S, D, R, H,
     UP, DOWN, LEFT, RIGHT,
     RETURN, SPACE, ESCAPE,
     PAGE_UP, PAGE_DOWN,
@@ -1,6 +1,7 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <windows.h>
 
@@ -12,6 +13,7 @@
 #include "qg_memory.hpp"
 #include "qg_parse.hpp"
 #include "qg_random.hpp"
+#include "qg_replay.hpp"
 #include "shared.hpp"
 
 // ------------- GAMELIB LOADING
@@ -79,6 +81,7 @@ void gamelib_refresh() {
 #define WINDOW_VERSION "ALPHA" //TODO: Export version from the main game DLL
 #define WINDOW_TITLE "Grav - 85"
 #define WINDOW_FPS 60
+#define CORE_MEM_RESERVE (256ull * 1024 * 1024) // Address space for the game state, committed as used
 
 static const u64 NS_PER_FRAME = (1000 * 1000 * 1000 / WINDOW_FPS);
 static const u64 MAX_LAG_TIME = NS_PER_FRAME * 5; // Cap catchup to 5 ticks
@@ -88,25 +91,104 @@ bool g_running = true;
 i32 window_width = 800;
 i32 window_height = 600;
 
-int main(int argc, char **argv) {
-    rand_seed(time(NULL));
+#if BUS_STATS
+static void on_bus_budget_exceeded(event_type type, void *data, void *user_data) {
+    perf_budget_exceeded_event *e = (perf_budget_exceeded_event *)data;
+    printf("[QG] Bus budget exceeded: %s = %.0f (budget %.0f)\n", e->budget_name, e->current_value, e->budget_value);
+}
+#endif
+
+#if MEM_TRACKING
+static void memory_stat_fire(event_bus *bus, const char *name, u64 used, u64 peak, u64 capacity, u64 num_allocs) {
+    perf_memory_stats_event e {};
+    snprintf(e.name, sizeof(e.name), "%s", name);
+    e.used_bytes = used;
+    e.peak_bytes = peak;
+    e.capacity_bytes = capacity;
+    e.num_allocs = num_allocs;
+    bus_fire_event(bus, event_type::PERF_MEMORY_STAT, e);
+}
 
-    if (!SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO)) {
-        printf("Could not init SDL3\nerror: %s\n", SDL_GetError());
-        return EXIT_FAILURE;
+static void memory_stats_fire(event_bus *bus) {
+    mem_heap_stats heap = mem_heap_get_stats();
+    memory_stat_fire(bus, "heap", heap.live_bytes, heap.peak_bytes, 0, heap.num_allocs);
+    memory_stat_fire(bus, "bus", bus_payload_bytes(bus), bus->peak_payload_bytes, bus->payload_capacity, bus->num_pages);
+    for (mem_arena *a = mem_tracked_arenas(); a; a = a->next_tracked) {
+        memory_stat_fire(bus, a->name, a->next, a->high_water, a->cap, a->num_allocs);
     }
-    printf("[QG] SDL3 Correctly init'ed!\n");
+}
 
-    SDL_Window *window;
-    SDL_Renderer *context;
-    if (!SDL_CreateWindowAndRenderer("[" WINDOW_VERSION "] " WINDOW_TITLE, window_width, window_height, SDL_WINDOW_RESIZABLE, &window, &context)) {
-        printf("Could not create Window or Renderer\nerror: %s\n", SDL_GetError());
-        return EXIT_FAILURE;
+static void memory_report_print(event_bus *bus) {
+    mem_print_report();
+    printf("[MEM] bus payload  %10llu / %10llu bytes peak frame, %u pages\n",
+        bus->peak_payload_bytes, bus->payload_capacity, bus->num_pages);
+}
+#endif
+
+// Headless: every tick of the recording through game_tick + bus_process, as fast as possible
+static i32 replay_run(replay_player *player, event_bus *bus, input_state *input) {
+    replay_start(player, bus);
+
+    u64 start = SDL_GetTicksNS();
+    while (replay_begin_tick(player, input)) {
+        game_tick(FRAME_TIME);
+        bus_process(bus);
+        replay_end_tick(player, game_state_checksum());
     }
-    if (!SDL_SetRenderVSync(context, 1)) {
-        printf("Could not set vsync on Renderer\nerror: %s\n", SDL_GetError());
+    f64 seconds = SDL_NS_TO_SECONDS((f64)(SDL_GetTicksNS() - start));
+
+    printf("[QG] Replayed %llu ticks, %llu events in %.3f s (%.0f ticks/s)\n",
+        player->num_ticks, player->num_events, seconds, seconds > 0 ? player->num_ticks / seconds : 0.0);
+    if (player->num_bad_ticks > 0) {
+        printf("[QG] Replay diverged on %llu ticks, first at tick %llu\n", player->num_bad_ticks, player->first_bad_tick);
         return EXIT_FAILURE;
     }
+    printf("[QG] Replay matches the recording\n");
+    return EXIT_SUCCESS;
+}
+
+// Usage: qg [--record <file>] [--replay <file>]
+int main(int argc, char **argv) {
+    const char *record_path = nullptr;
+    const char *replay_path = nullptr;
+    for (i32 i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            replay_path = argv[++i];
+        }
+    }
+
+    replay_player player {};
+    i64 seed = time(NULL);
+    if (replay_path) {
+        if (!replay_open(&player, replay_path)) {
+            printf("Could not open replay %s\n", replay_path);
+            return EXIT_FAILURE;
+        }
+        seed = player.seed;
+    }
+    rand_seed(seed);
+
+    // No window for a replay, nothing gets drawn
+    SDL_Window *window = nullptr;
+    SDL_Renderer *context = nullptr;
+    if (!replay_path) {
+        if (!SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO)) {
+            printf("Could not init SDL3\nerror: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
+        }
+        printf("[QG] SDL3 Correctly init'ed!\n");
+
+        if (!SDL_CreateWindowAndRenderer("[" WINDOW_VERSION "] " WINDOW_TITLE, window_width, window_height, SDL_WINDOW_RESIZABLE, &window, &context)) {
+            printf("Could not create Window or Renderer\nerror: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
+        }
+        if (!SDL_SetRenderVSync(context, 1)) {
+            printf("Could not set vsync on Renderer\nerror: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
+        }
+    }
     gamelib_load();
 
     // ENGINE INIT SEQUENCE
@@ -123,13 +205,18 @@ int main(int argc, char **argv) {
     event_bus g_bus {};
     bus_init(&g_bus, 2 * 1024 * 1024);
     g_eng.bus = &g_bus;
+#if BUS_STATS
+    bus_subscribe(&g_bus, event_type::PERF_BUDGET_EXCEEDED, on_bus_budget_exceeded);
+#endif
 
     input_state g_input {};
     input_init(&g_input);
     g_eng.input = &g_input;
 
     mem_arena g_core;
-    mem_arena_init(&g_core, game_state_size());
+    assert(game_state_size() <= CORE_MEM_RESERVE && "Game state does not fit the core arena");
+    mem_arena_init_virtual(&g_core, CORE_MEM_RESERVE);
+    mem_arena_track(&g_core, "core");
     g_eng.core_mem = &g_core;
 
     g_eng.context = context;
@@ -137,8 +224,33 @@ int main(int argc, char **argv) {
     // GAME INIT SEQUENCE
     game_init(g_eng);
 
+    if (replay_path) {
+        i32 result = replay_run(&player, &g_bus, &g_input);
+        replay_close(&player);
+#if MEM_TRACKING
+        memory_report_print(&g_bus);
+#endif
+        game_exit();
+        gamelib_free();
+        SDL_Quit();
+        return result;
+    }
+
+    replay_recorder recorder {};
+    if (record_path) {
+        if (replay_record_open(&recorder, record_path, &g_bus, seed)) {
+            printf("[QG] Recording to %s\n", record_path);
+        } else {
+            printf("[QG] Could not open %s for recording\n", record_path);
+            record_path = nullptr;
+        }
+    }
+
     u64 last_time = SDL_GetTicksNS();
     u64 lag_time = 0;
+#if MEM_TRACKING
+    u64 next_memory_stat = last_time;
+#endif
     SDL_Event event;
     while (g_running) {
 
@@ -179,9 +291,18 @@ int main(int argc, char **argv) {
         }
         input_update(&g_input);
 
+#if MEM_TRACKING
+        if (this_time >= next_memory_stat) {
+            memory_stats_fire(&g_bus);
+            next_memory_stat = this_time + SDL_NS_PER_SECOND;
+        }
+#endif
+
         while (lag_time >= NS_PER_FRAME) {
+            if (record_path) replay_record_begin_tick(&recorder, &g_input);
             game_tick(FRAME_TIME);
             bus_process(g_eng.bus);
+            if (record_path) replay_record_end_tick(&recorder, game_state_checksum());
 
             lag_time -= NS_PER_FRAME;
         }
@@ -195,9 +316,17 @@ int main(int argc, char **argv) {
         SDL_RenderPresent(context);
 
     }
+    if (record_path) replay_record_close(&recorder);
+#if MEM_TRACKING
+    memory_report_print(&g_bus);
+#endif
     game_exit();
     gamelib_free();
 
+#if BUS_STATS
+    bus_stats_print(&g_bus);
+#endif
+
     SDL_DestroyWindow(window);
     SDL_Quit();
     printf("[QG] quitting SDL3!\n");
@@ -1,21 +1,147 @@
 #include "qg_memory.hpp"
+#include <atomic>
+#include <cstdio>
 #include <cstdlib>
 
+#ifdef _WIN32
+// Declared here rather than through <windows.h>, whose macros (near, far, min, max) would
+// leak into the tools' unity builds that include this file
+extern "C" {
+__declspec(dllimport) void *__stdcall VirtualAlloc(void *address, size_t size, unsigned long type, unsigned long protect);
+__declspec(dllimport) int __stdcall VirtualFree(void *address, size_t size, unsigned long type);
+}
+#define WIN_MEM_COMMIT 0x1000
+#define WIN_MEM_RESERVE 0x2000
+#define WIN_MEM_DECOMMIT 0x4000
+#define WIN_MEM_RELEASE 0x8000
+#define WIN_PAGE_NOACCESS 0x01
+#define WIN_PAGE_READWRITE 0x04
+#else
+#include <sys/mman.h>
+#endif
+
+#if MEM_TRACKING
+// Each block carries its size in a header in front of it, so frees can be counted
+#define MEM_HEAP_HEADER 16 // Keeps malloc's alignment for the caller
+
+static std::atomic<u64> g_heap_live_bytes;
+static std::atomic<u64> g_heap_peak_bytes;
+static std::atomic<u64> g_heap_allocs;
+static std::atomic<u64> g_heap_frees;
+
+static mem_arena *g_tracked_arenas;
+
+static void *mem_heap_track(void *block, u64 size) {
+    if (block == nullptr) return nullptr;
+
+    *(u64 *)block = size;
+    g_heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    u64 live = g_heap_live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    u64 peak = g_heap_peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !g_heap_peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+    return (u8 *)block + MEM_HEAP_HEADER;
+}
+
+// Takes a block back out of the counters, returns what malloc gave for it
+static void *mem_heap_untrack(void *ptr) {
+    u8 *block = (u8 *)ptr - MEM_HEAP_HEADER;
+    g_heap_frees.fetch_add(1, std::memory_order_relaxed);
+    g_heap_live_bytes.fetch_sub(*(u64 *)block, std::memory_order_relaxed);
+    return block;
+}
+#endif
+
 //TODO: Add memory tracking w/ profiler? Tracy
 void *qg_malloc(u64 size) {
+#if MEM_TRACKING
+    return mem_heap_track(malloc(size + MEM_HEAP_HEADER), size);
+#else
     return malloc(size);
+#endif
 }
 
 void *qg_calloc(u64 count, u64 size) {
+#if MEM_TRACKING
+    // calloc checks count * size itself, here it is ours to check, header included
+    if (size && count > (SIZE_MAX - MEM_HEAP_HEADER) / size) return nullptr;
+    return mem_heap_track(calloc(1, count * size + MEM_HEAP_HEADER), count * size);
+#else
     return calloc(count, size);
+#endif
 }
 
 void *qg_realloc(void *ptr, u64 size) {
+#if MEM_TRACKING
+    if (ptr == nullptr) return qg_malloc(size);
+
+    void *block = realloc((u8 *)ptr - MEM_HEAP_HEADER, size + MEM_HEAP_HEADER);
+    if (block == nullptr) return nullptr; // ptr is still valid and still counted
+
+    // Counted as a free and an alloc, the header came along with the old size
+    mem_heap_untrack((u8 *)block + MEM_HEAP_HEADER);
+    return mem_heap_track(block, size);
+#else
     return realloc(ptr, size);
+#endif
 }
 
 void qg_free(void *ptr) {
+#if MEM_TRACKING
+    if (ptr == nullptr) return;
+    free(mem_heap_untrack(ptr));
+#else
     free(ptr);
+#endif
+}
+
+mem_heap_stats mem_heap_get_stats() {
+    mem_heap_stats stats {};
+#if MEM_TRACKING
+    stats.live_bytes = g_heap_live_bytes.load(std::memory_order_relaxed);
+    stats.peak_bytes = g_heap_peak_bytes.load(std::memory_order_relaxed);
+    stats.num_allocs = g_heap_allocs.load(std::memory_order_relaxed);
+    stats.num_frees = g_heap_frees.load(std::memory_order_relaxed);
+#endif
+    return stats;
+}
+
+// VIRTUAL MEMORY -----------------------------------
+
+static u8 *mem_reserve(u64 size) {
+#ifdef _WIN32
+    return (u8 *)VirtualAlloc(nullptr, size, WIN_MEM_RESERVE, WIN_PAGE_NOACCESS);
+#else
+    void *p = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return p == MAP_FAILED ? nullptr : (u8 *)p;
+#endif
+}
+
+static bool mem_commit(u8 *p, u64 size) {
+#ifdef _WIN32
+    return VirtualAlloc(p, size, WIN_MEM_COMMIT, WIN_PAGE_READWRITE) != nullptr;
+#else
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+// The range stays reserved, its pages are handed back to the OS
+static void mem_decommit(u8 *p, u64 size) {
+#ifdef _WIN32
+    VirtualFree(p, size, WIN_MEM_DECOMMIT);
+#else
+    madvise(p, size, MADV_DONTNEED);
+    mprotect(p, size, PROT_NONE);
+#endif
+}
+
+static void mem_release(u8 *p, u64 size) {
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(p, 0, WIN_MEM_RELEASE);
+#else
+    munmap(p, size);
+#endif
 }
 
 // MEMORY ARENA -----------------------------------
@@ -27,6 +153,14 @@ static inline u64 align_fwd(u64 ptr, u64 align) {
     return (ptr + m) & ~m;
 }
 
+#if MEM_TRACKING
+static inline void mem_arena_note_alloc(mem_arena *arena, u64 start, u64 end) {
+    arena->num_allocs++;
+    arena->wasted_bytes += start - arena->next;
+    if (end > arena->high_water) arena->high_water = end;
+}
+#endif
+
 void mem_arena_init(mem_arena *arena, u64 max_size) {
     arena->base = (u8*)qg_malloc(max_size);
     if (arena->base == nullptr) {
@@ -34,32 +168,89 @@ void mem_arena_init(mem_arena *arena, u64 max_size) {
     }
     arena->next = 0;
     arena->cap = max_size;
+    arena->committed = max_size;
+    arena->keep_committed = max_size;
+    arena->is_virtual = false;
+
+#if MEM_TRACKING
+    arena->high_water = 0;
+    arena->num_allocs = 0;
+    arena->wasted_bytes = 0;
+#endif
+}
+
+void mem_arena_init_virtual(mem_arena *arena, u64 max_size, u64 keep_committed) {
+    max_size = align_fwd(max_size, MEM_COMMIT_SIZE);
+    arena->base = mem_reserve(max_size);
+    if (arena->base == nullptr) {
+        assert(false && "ASSERT: Could not reserve new mem_arena");
+    }
+    arena->next = 0;
+    arena->cap = max_size;
+    arena->committed = 0;
+    arena->keep_committed = keep_committed < max_size ? align_fwd(keep_committed, MEM_COMMIT_SIZE) : max_size;
+    arena->is_virtual = true;
+
+#if MEM_TRACKING
+    arena->high_water = 0;
+    arena->num_allocs = 0;
+    arena->wasted_bytes = 0;
+#endif
+}
+
+// Allocations past the committed bytes land here, out of the way of the fast path
+static bool mem_arena_commit(mem_arena *arena, u64 end) {
+    if (!arena->is_virtual || end > arena->cap) return false;
+
+    u64 committed = align_fwd(end, MEM_COMMIT_SIZE);
+    if (!mem_commit(arena->base + arena->committed, committed - arena->committed)) return false;
+    arena->committed = committed;
+    return true;
 }
 
 void mem_arena_reset(mem_arena *arena) {
-    //TODO: Maybe adding tracking information here, updated only for debug builds
     arena->next = 0;
     arena->gen++;
+
+    if (arena->is_virtual && arena->committed > arena->keep_committed) {
+        mem_decommit(arena->base + arena->keep_committed, arena->committed - arena->keep_committed);
+        arena->committed = arena->keep_committed;
+    }
 }
 
 void mem_arena_clear(mem_arena *arena) {
-    //TODO: Maybe adding tracking information here, updated only for debug builds
-    qg_free(arena->base);
+#if MEM_TRACKING
+    if (arena->name) {
+        mem_arena **link = &g_tracked_arenas;
+        while (*link != arena) link = &(*link)->next_tracked;
+        *link = arena->next_tracked;
+        arena->name = nullptr;
+        arena->next_tracked = nullptr;
+    }
+#endif
+    if (arena->is_virtual) {
+        mem_release(arena->base, arena->cap);
+    } else {
+        qg_free(arena->base);
+    }
     arena->base = nullptr;
 
     arena->next = 0;
     arena->cap = 0;
+    arena->committed = 0;
     arena->gen++;
 }
 
 arena_ptr mem_arena_alloc(mem_arena *arena, u64 size, u64 align) {
-    //TODO: Maybe adding tracking information here, updated only for debug builds
     u64 off = align_fwd(arena->next, align);
 
-    if (off + size > arena->cap) {
+    if (off + size > arena->committed && !mem_arena_commit(arena, off + size)) {
         assert(false && "ASSERT: mem_arena ran out of allocated memory");
         return { nullptr, arena->gen };
     }
+#if MEM_TRACKING
+    mem_arena_note_alloc(arena, off, off + size);
+#endif
     u8 *ptr = arena->base + off;
     arena->next = off + size;
     return { ptr, arena->gen };
@@ -68,11 +259,50 @@ arena_ptr mem_arena_alloc(mem_arena *arena, u64 size, u64 align) {
 arena_off mem_arena_offloc(mem_arena *arena, u64 size, u64 align) {
     u64 off = align_fwd(arena->next, align);
 
-    if (off + size > arena->cap) {
+    if (off + size > arena->committed && !mem_arena_commit(arena, off + size)) {
         assert(false && "ASSERT: mem_arena ran out of allocated memory");
         return { UINT64_MAX, arena->gen }; //TODO: This is dangerous, need to rethink invalid offsets
     }
+#if MEM_TRACKING
+    mem_arena_note_alloc(arena, off, off + size);
+#endif
 
     arena->next = off + size;
     return { off, arena->gen };
 }
+
+void mem_arena_track(mem_arena *arena, const char *name) {
+#if MEM_TRACKING
+    if (arena->name == nullptr) {
+        arena->next_tracked = g_tracked_arenas;
+        g_tracked_arenas = arena;
+    }
+    arena->name = name;
+#else
+    (void)arena;
+    (void)name;
+#endif
+}
+
+mem_arena *mem_tracked_arenas() {
+#if MEM_TRACKING
+    return g_tracked_arenas;
+#else
+    return nullptr;
+#endif
+}
+
+void mem_print_report() {
+#if MEM_TRACKING
+    mem_heap_stats heap = mem_heap_get_stats();
+    printf("[MEM] heap: %llu bytes live, %llu peak, %llu allocs, %llu frees\n",
+        heap.live_bytes, heap.peak_bytes, heap.num_allocs, heap.num_frees);
+
+    for (mem_arena *a = g_tracked_arenas; a; a = a->next_tracked) {
+        printf("[MEM] arena %-12s %10llu / %10llu bytes high water (%5.1f%%), %llu allocs, %llu bytes lost to alignment",
+            a->name, a->high_water, a->cap, a->cap ? 100.0 * a->high_water / a->cap : 0.0, a->num_allocs, a->wasted_bytes);
+        if (a->is_virtual) printf(", %llu committed", a->committed);
+        printf("\n");
+    }
+#endif
+}
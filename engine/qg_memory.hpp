@@ -3,18 +3,45 @@
 
 #include <cassert>
 
+// Debug builds count what qg_malloc hands out and how each mem_arena is used, for the
+// PERF_MEMORY_STAT events and the report on exit. Defining NDEBUG compiles it out, the
+// mem_arena fields included; -DMEM_TRACKING=0/1 overrides that either way. The engine and
+// the game have to agree on it since they share the mem_arena layout.
+#ifndef MEM_TRACKING
+#ifdef NDEBUG
+#define MEM_TRACKING 0
+#else
+#define MEM_TRACKING 1
+#endif
+#endif
+
 void *qg_malloc(u64 sz);
 void *qg_calloc(u64 count, u64 sz);
 void *qg_realloc(void *ptr, u64 sz);
 void qg_free(void *ptr);
 
+// Virtual arenas reserve their whole range up front and commit it in steps of this many
+// bytes as allocations reach them, a multiple of the page size everywhere we run
+#define MEM_COMMIT_SIZE (64 * 1024)
+#define MEM_KEEP_COMMITTED UINT64_MAX   // mem_arena_init_virtual: never decommit on reset
+
 struct mem_arena {
     u8 *base = nullptr;
     u64 next;
     u64 cap;
     u64 gen;
 
-    //TODO: Maybe adding tracking information here, updated only for debug builds
+    u64 committed;                      // Usable bytes from base, cap for heap arenas
+    u64 keep_committed;                 // Virtual arenas: reset decommits past this
+    bool is_virtual;
+
+#if MEM_TRACKING
+    const char *name = nullptr;         // Set by mem_arena_track, only named arenas are reported
+    mem_arena *next_tracked = nullptr;
+    u64 high_water;                     // Most of cap ever in use, across resets
+    u64 num_allocs;
+    u64 wasted_bytes;                   // Skipped to align allocations
+#endif
 };
 
 struct arena_ptr {
@@ -27,13 +54,36 @@ struct arena_off {
     u64 gen;
 };
 
+// Heap totals since startup, all zero without MEM_TRACKING
+struct mem_heap_stats {
+    u64 live_bytes;
+    u64 peak_bytes;
+    u64 num_allocs;
+    u64 num_frees;
+};
+
 void mem_arena_init(mem_arena *arena, u64 max_size);
+// Reserves max_size of address space without backing it, pages are committed as next moves
+// past them. Resets give back what is committed past keep_committed (rounded up to
+// MEM_COMMIT_SIZE), MEM_KEEP_COMMITTED keeps everything. Decommitted pages read as zero
+// when they come back. mem_arena_reset and mem_arena_clear work on both kinds.
+void mem_arena_init_virtual(mem_arena *arena, u64 max_size, u64 keep_committed = MEM_KEEP_COMMITTED);
 void mem_arena_reset(mem_arena *arena);
 void mem_arena_clear(mem_arena *arena);
 
 arena_ptr mem_arena_alloc(mem_arena *arena, u64 size, u64 align = sizeof(void *));
 arena_off mem_arena_offloc(mem_arena *arena, u64 size, u64 align = sizeof(void *));
 
+// Names an arena for the memory report and PERF_MEMORY_STAT, name must be a static literal.
+// The arena stays listed until mem_arena_clear, call it before the arena goes away.
+// Does nothing without MEM_TRACKING.
+void mem_arena_track(mem_arena *arena, const char *name);
+
+// Engine only
+mem_heap_stats mem_heap_get_stats();
+mem_arena *mem_tracked_arenas();        // Follow next_tracked, nullptr without MEM_TRACKING
+void mem_print_report();
+
 template<class T>
 static inline T *mem_arena_at(mem_arena *arena, arena_off offset) {
     assert(arena->gen == offset.gen && "Trying to access stale offset in arena");
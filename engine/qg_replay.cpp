@@ -0,0 +1,247 @@
+#include "qg_replay.hpp"
+#include "qg_bus.hpp"
+#include "qg_input.hpp"
+#include "qg_memory.hpp"
+
+#include "SDL3/SDL.h"
+#include <cstring>
+
+#define REPLAY_BUFFER_SIZE (64 * 1024)
+// Once a replay diverges every later tick usually does too: only the first few bad ticks,
+// and the first few mismatches in each, are printed, the rest are only counted
+#define REPLAY_REPORTED_TICKS 4
+#define REPLAY_REPORTED_MISMATCHES 8
+
+// The bus fires PERF_BUDGET_EXCEEDED on its own in debug builds, depending on timing, and
+// its payload points into the process that fired it: never recorded, fired or compared
+static inline bool replay_ignores(u16 type) {
+    return type == (u16)event_type::PERF_BUDGET_EXCEEDED;
+}
+
+// RECORDING -----------------------------------
+
+static void replay_record_event(replay_recorder *rec, event_type type, u32 subject, const void *data, u32 size, u16 flags) {
+    u64 needed = rec->buffer_size + sizeof(replay_event_header) + size;
+    if (needed > rec->buffer_capacity) {
+        u64 capacity = rec->buffer_capacity * 2;
+        while (capacity < needed) capacity *= 2;
+        u8 *buffer = (u8 *)qg_realloc(rec->buffer, capacity);
+        if (!buffer) {
+            rec->failed = true;
+            return;
+        }
+        rec->buffer = buffer;
+        rec->buffer_capacity = capacity;
+    }
+
+    replay_event_header h { (u16)type, flags, subject, size };
+    memcpy(rec->buffer + rec->buffer_size, &h, sizeof(h));
+    if (size > 0) memcpy(rec->buffer + rec->buffer_size + sizeof(h), data, size);
+    rec->buffer_size = needed;
+    rec->tick.num_events++;
+}
+
+static void replay_record_tap(event_type type, u32 subject, const void *data, u32 data_size, void *user_data) {
+    if (replay_ignores((u16)type)) return;
+    replay_record_event((replay_recorder *)user_data, type, subject, data, data_size, 0);
+}
+
+bool replay_record_open(replay_recorder *rec, const char *path, event_bus *bus, i64 seed) {
+    i32 err = fopen_s(&rec->file, path, "wb");
+    if (err != 0 || !rec->file) return false;
+
+    replay_file_header h { REPLAY_FILE_MAGIC, REPLAY_FILE_VERSION, seed };
+    rec->failed = fwrite(&h, sizeof(h), 1, rec->file) != 1;
+
+    rec->bus = bus;
+    rec->buffer = (u8 *)qg_malloc(REPLAY_BUFFER_SIZE);
+    rec->buffer_size = 0;
+    rec->buffer_capacity = REPLAY_BUFFER_SIZE;
+    rec->num_ticks = 0;
+    rec->num_events = 0;
+    rec->bytes_written = sizeof(h);
+
+    bus_set_tap(bus, replay_record_tap, rec);
+    return true;
+}
+
+void replay_record_close(replay_recorder *rec) {
+    bus_set_tap(rec->bus, nullptr);
+
+    bool ok = fclose(rec->file) == 0 && !rec->failed;
+    qg_free(rec->buffer);
+    rec->file = nullptr;
+    rec->buffer = nullptr;
+
+    printf("[QG] Recorded %llu ticks, %llu events, %llu bytes%s\n",
+        rec->num_ticks, rec->num_events, rec->bytes_written, ok ? "" : " (write failed, recording is incomplete)");
+}
+
+void replay_record_begin_tick(replay_recorder *rec, input_state *input) {
+    rec->buffer_size = 0;
+    rec->tick.tick = rec->num_ticks;
+    rec->tick.checksum = 0;
+    rec->tick.input_down = input->down;
+    rec->tick.input_pressed = input->pressed;
+    rec->tick.input_released = input->released;
+    rec->tick.input_prev_down = input->prev_down;
+    rec->tick.num_events = 0;
+
+    // Whatever the engine fired since the last tick is still queued, the game's own events
+    // come from game_tick and are regenerated by the replay
+    event_bus *bus = rec->bus;
+    for (u32 i = bus->head; i < bus->tail; i++) {
+        event_entry *e = i < BUS_MAX_EVENTS_PER_FRAME ? &bus->events[i] : &bus->overflow[i - BUS_MAX_EVENTS_PER_FRAME];
+        if (replay_ignores((u16)e->type)) continue;
+        replay_record_event(rec, e->type, e->subject, e->data, e->data_size, REPLAY_EVENT_FIRED);
+    }
+}
+
+void replay_record_end_tick(replay_recorder *rec, u64 checksum) {
+    rec->tick.checksum = checksum;
+    rec->tick.events_bytes = (u32)rec->buffer_size;
+
+    if (!rec->failed) {
+        rec->failed = fwrite(&rec->tick, sizeof(rec->tick), 1, rec->file) != 1 ||
+            (rec->buffer_size > 0 && fwrite(rec->buffer, rec->buffer_size, 1, rec->file) != 1);
+    }
+    if (!rec->failed) {
+        rec->bytes_written += sizeof(rec->tick) + rec->buffer_size;
+        rec->num_ticks++;
+        rec->num_events += rec->tick.num_events;
+    }
+}
+
+// REPLAY -----------------------------------
+
+// Records are packed, so headers are copied out rather than read in place
+static u8 *replay_read_event(u8 *it, replay_event_header *h) {
+    memcpy(h, it, sizeof(*h));
+    return it + sizeof(*h);
+}
+
+// Next recorded dispatched event of the tick, false past the last one. Recordings from
+// before replay_ignores may still hold budget events, they are skipped like fired ones.
+static bool replay_next_expected(replay_player *p, replay_event_header *h, u8 **payload) {
+    u8 *end = p->events + p->tick.events_bytes;
+    while (p->expected < end) {
+        *payload = replay_read_event(p->expected, h);
+        p->expected = *payload + h->size;
+        if (!(h->flags & REPLAY_EVENT_FIRED) && !replay_ignores(h->type)) return true;
+    }
+    return false;
+}
+
+static void replay_mismatch(replay_player *p, const char *what, u16 type, u32 size) {
+    if (p->num_bad_ticks < REPLAY_REPORTED_TICKS && p->tick_mismatches < REPLAY_REPORTED_MISMATCHES) {
+        printf("[QG] Replay tick %llu: %s (type %u, %u bytes)\n", p->tick.tick, what, type, size);
+    }
+    p->tick_mismatches++;
+}
+
+static void replay_tap(event_type type, u32 subject, const void *data, u32 data_size, void *user_data) {
+    replay_player *p = (replay_player *)user_data;
+    if (replay_ignores((u16)type)) return;
+    p->num_events++;
+
+    replay_event_header h;
+    u8 *payload;
+    if (!replay_next_expected(p, &h, &payload)) {
+        replay_mismatch(p, "event not in the recording", (u16)type, data_size);
+        return;
+    }
+
+    if (h.type != (u16)type || h.subject != subject || h.size != data_size) {
+        replay_mismatch(p, "different event than recorded", (u16)type, data_size);
+    } else if (data_size > 0 && memcmp(payload, data, data_size) != 0) {
+        replay_mismatch(p, "event payload differs", (u16)type, data_size);
+    }
+}
+
+bool replay_open(replay_player *p, const char *path) {
+    memset(p, 0, sizeof(*p));
+
+    size_t size = 0;
+    p->data = (u8 *)SDL_LoadFile(path, &size);
+    if (!p->data) return false;
+    p->size = size;
+
+    replay_file_header h;
+    if (p->size < sizeof(h)) {
+        replay_close(p);
+        return false;
+    }
+    memcpy(&h, p->data, sizeof(h));
+    if (h.magic != REPLAY_FILE_MAGIC || h.version != REPLAY_FILE_VERSION) {
+        printf("[QG] %s is not a version %d replay\n", path, REPLAY_FILE_VERSION);
+        replay_close(p);
+        return false;
+    }
+
+    p->seed = h.seed;
+    p->offset = sizeof(h);
+    return true;
+}
+
+void replay_close(replay_player *p) {
+    if (p->bus) bus_set_tap(p->bus, nullptr);
+    SDL_free(p->data);
+    p->data = nullptr;
+}
+
+void replay_start(replay_player *p, event_bus *bus) {
+    p->bus = bus;
+    bus_set_tap(bus, replay_tap, p);
+}
+
+bool replay_begin_tick(replay_player *p, input_state *input) {
+    if (p->offset + sizeof(replay_tick_header) > p->size) return false;
+
+    memcpy(&p->tick, p->data + p->offset, sizeof(p->tick));
+    if (p->offset + sizeof(replay_tick_header) + p->tick.events_bytes > p->size) {
+        printf("[QG] Replay ends in the middle of tick %llu\n", p->tick.tick);
+        return false;
+    }
+    p->events = p->data + p->offset + sizeof(replay_tick_header);
+    p->expected = p->events;
+    p->offset += sizeof(replay_tick_header) + p->tick.events_bytes;
+    p->tick_mismatches = 0;
+
+    input->down = p->tick.input_down;
+    input->pressed = p->tick.input_pressed;
+    input->released = p->tick.input_released;
+    input->prev_down = p->tick.input_prev_down;
+
+    u8 *end = p->events + p->tick.events_bytes;
+    for (u8 *it = p->events; it < end;) {
+        replay_event_header h;
+        u8 *payload = replay_read_event(it, &h);
+        if ((h.flags & REPLAY_EVENT_FIRED) && !replay_ignores(h.type)) {
+            bus_fire_subject(p->bus, (event_type)h.type, h.subject, payload, h.size);
+        }
+        it = payload + h.size;
+    }
+    return true;
+}
+
+bool replay_end_tick(replay_player *p, u64 checksum) {
+    replay_event_header h;
+    u8 *payload;
+    while (replay_next_expected(p, &h, &payload)) {
+        replay_mismatch(p, "recorded event not dispatched", h.type, h.size);
+    }
+    if (checksum != p->tick.checksum) {
+        if (p->num_bad_ticks < REPLAY_REPORTED_TICKS) {
+            printf("[QG] Replay tick %llu: state checksum %016llx, recorded %016llx\n", p->tick.tick, checksum, p->tick.checksum);
+        }
+        p->tick_mismatches++;
+    }
+
+    p->num_ticks++;
+    if (p->tick_mismatches > 0) {
+        if (p->num_bad_ticks == 0) p->first_bad_tick = p->tick.tick;
+        p->num_bad_ticks++;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "shared_types.hpp"
+
+#include <cstdio>
+
+// Event stream recording and deterministic replay (engine only, not exposed to the game)
+//
+// A recording holds, for every fixed-timestep tick, the input_state bitmasks the tick ran
+// with, the events the engine had queued before it (window resizes and the like), every
+// event bus_process dispatched, and the game's state checksum after the tick. Replaying
+// sets the same input, fires the same engine events, runs game_tick + bus_process and
+// checks the dispatched events and the checksum against the recording, tick by tick.
+//
+// File layout, little endian, written as raw structs:
+//   replay_file_header
+//   per tick: replay_tick_header, then events_bytes of event records
+//   event record: replay_event_header, then size payload bytes (no padding)
+//
+// PERF_BUDGET_EXCEEDED, which the bus fires itself in debug builds, is left out entirely.
+// Events fired from other threads (bus_fire_async) are recorded as dispatched but not fed
+// back, a replay of a tick that had some reports it as a mismatch.
+
+#define REPLAY_FILE_MAGIC 0x52353847u // "G85R"
+#define REPLAY_FILE_VERSION 2
+
+#define REPLAY_EVENT_FIRED 0x1 // Queued by the engine before the tick, fired again on replay
+
+struct replay_file_header {
+    u32 magic;
+    u32 version;
+    i64 seed;           // rand_seed for the run
+};
+
+struct replay_tick_header {
+    u64 tick;           // From 0, one per game_tick
+    u64 checksum;       // game_state_checksum after the tick's bus_process
+    u32 input_down;
+    u32 input_pressed;
+    u32 input_released;
+    u32 input_prev_down;
+    u32 num_events;
+    u32 events_bytes;
+};
+
+struct replay_event_header {
+    u16 type;
+    u16 flags;
+    u32 subject;        // BUS_NO_SUBJECT for plain bus_fire events
+    u32 size;
+};
+
+struct event_bus;
+struct input_state;
+
+struct replay_recorder {
+    FILE *file;
+    event_bus *bus;
+    bool failed;        // A write failed, the rest of the run isn't recorded
+
+    // Event records of the tick being recorded, written out with its header
+    u8 *buffer;
+    u64 buffer_size;
+    u64 buffer_capacity;
+    replay_tick_header tick;
+
+    u64 num_ticks;
+    u64 num_events;
+    u64 bytes_written;
+};
+
+// Starts recording to path; taps the bus until replay_record_close
+bool replay_record_open(replay_recorder *rec, const char *path, event_bus *bus, i64 seed);
+void replay_record_close(replay_recorder *rec);
+
+// Around each game_tick + bus_process
+void replay_record_begin_tick(replay_recorder *rec, input_state *input);
+void replay_record_end_tick(replay_recorder *rec, u64 checksum);
+
+struct replay_player {
+    u8 *data;           // The whole file
+    u64 size;
+    u64 offset;         // Next tick header
+    i64 seed;
+    event_bus *bus;
+
+    // Tick being replayed
+    replay_tick_header tick;
+    u8 *events;
+    u8 *expected;       // Next recorded record the tap compares against
+    u32 tick_mismatches;
+
+    u64 num_ticks;
+    u64 num_events;     // Dispatched events checked
+    u64 num_bad_ticks;
+    u64 first_bad_tick;
+};
+
+// Loads a recording, seed is valid once this returns true
+bool replay_open(replay_player *p, const char *path);
+void replay_close(replay_player *p);
+
+// Taps the bus, call once the engine and the game are initialized
+void replay_start(replay_player *p, event_bus *bus);
+
+// Sets the recorded input and fires the recorded engine events; false after the last tick
+bool replay_begin_tick(replay_player *p, input_state *input);
+// False if the dispatched events or the checksum differ from the recording
+bool replay_end_tick(replay_player *p, u64 checksum);
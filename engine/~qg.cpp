@@ -4,5 +4,6 @@
 #include "qg_memory.cpp"
 #include "qg_parse.cpp"
 #include "qg_random.cpp"
+#include "qg_replay.cpp"
 
 #include "qg_main.cpp"
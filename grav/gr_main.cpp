@@ -18,7 +18,7 @@ enum class game_action : u8 {
     GRAVITY_UP, GRAVITY_DOWN, GRAVITY_LEFT, GRAVITY_RIGHT,
     MENU_UP, MENU_DOWN, MENU_LEFT, MENU_RIGHT,
     MENU_CONFIRM, MENU_CANCEL,
-    RESET, DEBUG_PREV_LEVEL, DEBUG_NEXT_LEVEL,
+    RESET, HINT, DEBUG_PREV_LEVEL, DEBUG_NEXT_LEVEL,
     COUNT
 };
 
@@ -27,15 +27,17 @@ enum class color : u8 { RED, GREEN, BLUE, COUNT };
 #define ELEMENTS_MAX_NUM 32
 
 struct level {
-    u8 solid[MAP_MAX_SIZE / 8];       // 1 bit per cell
+    u8 solid[MAP_MAX_SIZE / 8];       // 1 bit per cell, fixed crates included
     ivec2 crate_starts[ELEMENTS_MAX_NUM];
     ivec2 gem_starts[ELEMENTS_MAX_NUM];
     color gem_colors[ELEMENTS_MAX_NUM];
+    ivec2 fixed_crates[ELEMENTS_MAX_NUM]; // Crates that can never move, drawn as crates but simulated as walls
     direction start_gravity;
     i8 width;
     i8 height;
     i8 num_crates;
     i8 num_gems;
+    i8 num_fixed_crates;
 };
 
 inline bool level_is_solid(level *lvl, ivec2 pos) {
@@ -43,6 +45,50 @@ inline bool level_is_solid(level *lvl, ivec2 pos) {
     return (lvl->solid[idx / 8] >> (idx % 8)) & 1;
 }
 
+static bool level_blocked(level *lvl, u32 fixed, ivec2 pos) {
+    if (pos.x < 0 || pos.y < 0 || pos.x >= lvl->width || pos.y >= lvl->height) return true;
+    if (level_is_solid(lvl, pos)) return true;
+    for (i32 i = 0; i < lvl->num_crates; i++) {
+        if (lvl->crate_starts[i] == pos) return (fixed >> i) & 1;
+    }
+    return false;
+}
+
+// Crates walled in on every side by walls or other such crates can never move, so they
+// are folded into the solid map and left out of the attempt state entirely.
+// Must match level_analyze in tools/puzzlegen/pg_reduce.cpp, hint hashes leave them out too.
+void level_fold_fixed_crates(level *lvl) {
+    u32 fixed = lvl->num_crates >= 32 ? 0xFFFFFFFFu : (1u << lvl->num_crates) - 1;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (i32 i = 0; i < lvl->num_crates; i++) {
+            if (!((fixed >> i) & 1)) continue;
+            for (i32 d = 0; d < 4; d++) {
+                if (!level_blocked(lvl, fixed, lvl->crate_starts[i] + direction_vectors[d])) {
+                    fixed &= ~(1u << i);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    i8 num_movable = 0;
+    lvl->num_fixed_crates = 0;
+    for (i32 i = 0; i < lvl->num_crates; i++) {
+        ivec2 pos = lvl->crate_starts[i];
+        if ((fixed >> i) & 1) {
+            u32 idx = (pos.y * lvl->width) + pos.x;
+            lvl->solid[idx / 8] |= (1 << (idx % 8));
+            lvl->fixed_crates[lvl->num_fixed_crates++] = pos;
+        } else {
+            lvl->crate_starts[num_movable++] = pos;
+        }
+    }
+    lvl->num_crates = num_movable;
+}
+
 enum element_type : u8 { CRATE, GEM, COUNT };
 #define ATTEMPT_MAX_MOVES 99
 
@@ -74,6 +120,7 @@ void attempt_level_init(attempt *att, level *lvl) {
     att->num_crates = lvl->num_crates;
     att->num_gems = lvl->num_gems;
     att->num_moves = 0;
+    att->animating = false;
 }
 
 void attempt_level_reset(attempt *att, level *lvl) {
@@ -87,6 +134,7 @@ void attempt_level_reset(attempt *att, level *lvl) {
     att->num_crates = lvl->num_crates;
     att->num_gems = lvl->num_gems;
     att->num_moves = 0;
+    att->animating = false;
 }
 
 bool attempt_element_at(attempt *att, ivec2 pos) {
@@ -229,19 +277,146 @@ void attempt_check_combos(attempt *att, level *lvl) {
     }
 }
 
+// Headless version of a full move: slide, then resolve combo chains without waiting on animations
+void attempt_simulate_move(attempt *att, level *lvl, direction dir) {
+    attempt_gravity_change(att, lvl, dir);
+    while (true) {
+        memset(att->crate_offsets, 0, sizeof(att->crate_offsets));
+        memset(att->gem_offsets, 0, sizeof(att->gem_offsets));
+        att->animating = false;
+
+        u32 gems_before = att->gems_active;
+        attempt_check_combos(att, lvl);
+        if (att->gems_active == gems_before) break;
+    }
+}
+
+// Must match sim_state_hash in tools/puzzlegen/pg_solver.cpp, hint tables are keyed on it
+u64 attempt_state_hash(attempt *att, level *lvl) {
+    u64 h = 14695981039346656037ull;
+    auto fnv_byte = [&](u8 b) { h ^= b; h *= 1099511628211ull; };
+    auto fnv_i32 = [&](i32 v) {
+        fnv_byte((u8)(v));
+        fnv_byte((u8)(v >> 8));
+        fnv_byte((u8)(v >> 16));
+        fnv_byte((u8)(v >> 24));
+    };
+
+    ivec2 sorted_crates[ELEMENTS_MAX_NUM];
+    memcpy(sorted_crates, att->crates, sizeof(ivec2) * att->num_crates);
+    for (i32 i = 1; i < att->num_crates; i++) {
+        ivec2 key = sorted_crates[i];
+        i32 kv = key.y * 16 + key.x;
+        i32 j = i - 1;
+        while (j >= 0 && (sorted_crates[j].y * 16 + sorted_crates[j].x) > kv) {
+            sorted_crates[j + 1] = sorted_crates[j];
+            j--;
+        }
+        sorted_crates[j + 1] = key;
+    }
+    for (i32 i = 0; i < att->num_crates; i++) {
+        fnv_i32(sorted_crates[i].x);
+        fnv_i32(sorted_crates[i].y);
+    }
+
+    ivec2 sorted_gems[ELEMENTS_MAX_NUM];
+    color sorted_colors[ELEMENTS_MAX_NUM];
+    i32 num_active = 0;
+    for (i32 i = 0; i < att->num_gems; i++) {
+        if ((att->gems_active >> i) & 1) {
+            sorted_gems[num_active] = att->gems[i];
+            sorted_colors[num_active] = lvl->gem_colors[i];
+            num_active++;
+        }
+    }
+    for (i32 i = 1; i < num_active; i++) {
+        ivec2 kp = sorted_gems[i];
+        color kc = sorted_colors[i];
+        i32 kv = kp.y * 16 + kp.x;
+        i32 j = i - 1;
+        while (j >= 0 && (sorted_gems[j].y * 16 + sorted_gems[j].x) > kv) {
+            sorted_gems[j + 1] = sorted_gems[j];
+            sorted_colors[j + 1] = sorted_colors[j];
+            j--;
+        }
+        sorted_gems[j + 1] = kp;
+        sorted_colors[j + 1] = kc;
+    }
+    for (i32 i = 0; i < num_active; i++) {
+        fnv_i32(sorted_gems[i].x);
+        fnv_i32(sorted_gems[i].y);
+        fnv_byte((u8)sorted_colors[i]);
+    }
+
+    fnv_i32((i32)att->gems_active);
+    fnv_byte((u8)att->current_gravity);
+
+    return h;
+}
+
+// Distance-to-solution table written by puzzlegen (see tools/puzzlegen/pg_hints.cpp for the layout)
+#define HINT_FILE_MAGIC 0x48353847u // "G85H"
+#define HINT_FILE_VERSION 2
+
+struct hint_table {
+    u32 capacity;   // 0 = no hints for this level
+    u32 *keys;      // High half of the state hash, 0 = empty slot
+    u8 *dists;
+};
+
+bool hint_lookup(hint_table *t, u64 hash, u8 *dist) {
+    if (t->capacity == 0) return false;
+
+    u32 key = (u32)(hash >> 32);
+    if (key == 0) key = 1;
+
+    u32 mask = t->capacity - 1;
+    for (u32 slot = (u32)hash & mask; t->keys[slot] != 0; slot = (slot + 1) & mask) {
+        if (t->keys[slot] == key) {
+            *dist = t->dists[slot];
+            return true;
+        }
+    }
+    return false;
+}
+
+// Best next move from the current attempt state, direction::COUNT if no move leads to a solution
+direction hint_best_move(hint_table *t, attempt *att, level *lvl) {
+    direction best = direction::COUNT;
+    u8 best_dist = 0xFF;
+
+    for (i32 d = 0; d < 4; d++) {
+        direction dir = (direction)d;
+        if (dir == att->current_gravity) continue;
+
+        attempt next = *att;
+        attempt_simulate_move(&next, lvl, dir);
+
+        u8 dist;
+        if (hint_lookup(t, attempt_state_hash(&next, lvl), &dist) && dist < best_dist) {
+            best_dist = dist;
+            best = dir;
+        }
+    }
+    return best;
+}
+
 #define NUM_LEVEL_PER_MATCH 5
 #define BYTES_PER_LEVEL 108
 #define BYTES_PER_MATCH NUM_LEVEL_PER_MATCH * BYTES_PER_LEVEL
+#define MATCH_SCRATCH_RESERVE (16 * 1024 * 1024)
 
 struct match {
     level *levels;
     attempt *attempts;
     i8 *level_indices;
+    hint_table hints[NUM_LEVEL_PER_MATCH];
 
     i8 num_levels;
     i8 num_players;
 
     mem_arena _scratch;
+    u8 *_hint_data;
 };
 
 void match_read_level(level *lvl, u8 *data, u64 length) {
@@ -269,6 +444,8 @@ void match_read_level(level *lvl, u8 *data, u64 length) {
 
     u8 *solid_data = (u8*)&data[76];
     memcpy_s(lvl->solid, MAP_MAX_SIZE / 8, solid_data, MAP_MAX_SIZE / 8);
+
+    level_fold_fixed_crates(lvl);
 }
 
 void match_init(match *match, i8 num_players, u8 *data, u64 length) {
@@ -278,7 +455,9 @@ void match_init(match *match, i8 num_players, u8 *data, u64 length) {
             sizeof(attempt) * NUM_LEVEL_PER_MATCH * num_players + // Each attempts / level / player
             sizeof(i8) * num_players + // Current level / player
             64;
-        g_api.mem_arena_init(&match->_scratch, required_mem);
+        // Reserved well past what a match needs, only the pages it touches are committed
+        g_api.mem_arena_init_virtual(&match->_scratch, MATCH_SCRATCH_RESERVE, required_mem);
+        g_api.mem_arena_track(&match->_scratch, "match");
     } else {
         g_api.mem_arena_reset(&match->_scratch);
     }
@@ -308,10 +487,68 @@ void match_current_attempt(match *match, i8 player_index, level **lvl, attempt *
     *att = &match->attempts[(player_index * match->num_levels) + lvl_index];
 }
 
+// Optional: without a hint file every table stays empty and hints are simply unavailable
+bool match_load_hints(match *match, const char *file_path) {
+    if (match->_hint_data) {
+        g_api.qg_free(match->_hint_data);
+        match->_hint_data = nullptr;
+    }
+    memset(match->hints, 0, sizeof(match->hints));
+
+    FILE *f;
+    if (fopen_s(&f, file_path, "rb") != 0 || !f) return false;
+
+    fseek(f, 0, SEEK_END);
+    u64 file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    u8 *data = (u8*)g_api.qg_malloc(file_size);
+    u64 read_len = fread(data, 1, file_size, f);
+    fclose(f);
+
+    u32 magic = 0;
+    u16 version = 0, num_levels = 0;
+    if (read_len == file_size && file_size >= 8) {
+        memcpy(&magic, &data[0], sizeof(u32));
+        memcpy(&version, &data[4], sizeof(u16));
+        memcpy(&num_levels, &data[6], sizeof(u16));
+    }
+    if (magic != HINT_FILE_MAGIC || version != HINT_FILE_VERSION || num_levels != NUM_LEVEL_PER_MATCH) {
+        g_api.qg_free(data);
+        return false;
+    }
+
+    // Tables point straight into the file buffer
+    u64 off = 8;
+    for (i32 i = 0; i < NUM_LEVEL_PER_MATCH; i++) {
+        u32 capacity;
+        if (off + 8 > file_size) break;
+        memcpy(&capacity, &data[off], sizeof(u32));
+        off += 8; // capacity + num_entries
+
+        u64 table_size = (u64)capacity * (sizeof(u32) + sizeof(u8));
+        if (off + table_size > file_size) break;
+
+        match->hints[i].capacity = capacity;
+        match->hints[i].keys = (u32*)&data[off];
+        match->hints[i].dists = &data[off + (u64)capacity * sizeof(u32)];
+        off += table_size;
+    }
+
+    match->_hint_data = data;
+    return true;
+}
+
 void match_close(match *match) {
     match->num_levels = 0;
     match->num_players = 0;
 
+    if (match->_hint_data) {
+        g_api.qg_free(match->_hint_data);
+        match->_hint_data = nullptr;
+    }
+    memset(match->hints, 0, sizeof(match->hints));
+
     g_api.mem_arena_clear(&match->_scratch);
 }
 
@@ -375,6 +612,18 @@ f32 g_gravity_speed = 0;
 
 match g_match;
 i8 player_index = 0;
+direction g_hint_dir = direction::COUNT;
+
+bus_channel<level_gravity_changed_event> g_gravity_changed;
+
+// A gravity change makes the shown hint stale
+static void on_gravity_changed(const level_gravity_changed_event *events, u32 count, void *user_data) {
+    for (u32 i = 0; i < count; i++) {
+        if (events[i].player_index == player_index) {
+            g_hint_dir = direction::COUNT;
+        }
+    }
+}
 
 u64 grav_state_size() {
     return sizeof(game_state);
@@ -387,6 +636,7 @@ void grav_init(engine_api api) {
 
     // More logic here to make sure we can get the previous game_state in the case of hot reloading
     g_s = (game_state*)g_api.mem_arena_alloc(g_mem, grav_state_size(), alignof(game_state)).p;
+    g_s->phase = game_phase::INIT;
 
     // Register key bindings
     auto bind = [&](key_code k, game_action a) {
@@ -411,6 +661,7 @@ void grav_init(engine_api api) {
     bind(key_code::ESCAPE, game_action::MENU_CANCEL);
 
     bind(key_code::R,        game_action::RESET);
+    bind(key_code::H,        game_action::HINT);
     bind(key_code::PAGE_UP,  game_action::DEBUG_PREV_LEVEL);
     bind(key_code::PAGE_DOWN, game_action::DEBUG_NEXT_LEVEL);
 
@@ -430,7 +681,14 @@ void grav_init(engine_api api) {
     assert(read_len >= 1);
     fclose(lvl_file);
 
+    channel_init(&g_gravity_changed, (event_type)game_event_type::LEVEL_GRAVITY_CHANGED);
+    channel_subscribe(&g_gravity_changed, on_gravity_changed);
+    g_api.bus_add_channel(g_api.bus, &g_gravity_changed);
+
     match_init(&g_match, 1, lvl_data, BYTES_PER_MATCH);
+    if (match_load_hints(&g_match, "assets/bundle.hint")) {
+        printf("[GAME] Loaded hint tables\n");
+    }
 }
 
 void grav_tick(f32 dt) {
@@ -448,17 +706,26 @@ void grav_tick(f32 dt) {
 
     if (g_api.input_pressed(g_in, (u8)game_action::RESET)) {
         attempt_level_reset(att, lvl);
+        g_hint_dir = direction::COUNT;
     }
 
     if (g_api.input_pressed(g_in, (u8)game_action::DEBUG_PREV_LEVEL) && g_match.level_indices[player_index] > 0) {
         g_match.level_indices[player_index]--;
         match_current_attempt(&g_match, player_index, &lvl, &att);
+        g_hint_dir = direction::COUNT;
     }
     if (g_api.input_pressed(g_in, (u8)game_action::DEBUG_NEXT_LEVEL) && g_match.level_indices[player_index] < g_match.num_levels - 1) {
         g_match.level_indices[player_index]++;
         match_current_attempt(&g_match, player_index, &lvl, &att);
+        g_hint_dir = direction::COUNT;
+    }
+
+    i8 lvl_index = g_match.level_indices[player_index];
+    if (!att->animating && g_api.input_pressed(g_in, (u8)game_action::HINT)) {
+        g_hint_dir = hint_best_move(&g_match.hints[lvl_index], att, lvl);
     }
 
+    direction gravity_before = att->current_gravity;
     if (!att->animating  && g_api.input_pressed(g_in, (u8)game_action::GRAVITY_UP)) {
         attempt_gravity_change(att, lvl, direction::UP);
     }
@@ -471,6 +738,9 @@ void grav_tick(f32 dt) {
     else if (!att->animating  && g_api.input_pressed(g_in, (u8)game_action::GRAVITY_LEFT)) {
         attempt_gravity_change(att, lvl, direction::LEFT);
     }
+    if (att->current_gravity != gravity_before) {
+        channel_fire(&g_gravity_changed, { player_index, gravity_before, att->current_gravity });
+    }
 
     if (att->animating) {
         i32 num_moves = 0;
@@ -530,6 +800,21 @@ void grav_draw(f32 dt) {
     SDL_RenderLine(g_api.context, center_x + dx, center_y + dy, center_x + dx*0.5f + ax, center_y + dy*0.5f + ay);
     SDL_RenderLine(g_api.context, center_x + dx, center_y + dy, center_x + dx*0.5f - ax, center_y + dy*0.5f - ay);
 
+    // Render hint arrow next to the gravity indicator
+    if (g_hint_dir != direction::COUNT) {
+        f32 hint_x = center_x + 50.0f;
+        ivec2 hdir = direction_vectors[(i32)g_hint_dir];
+        f32 hx = (f32)hdir.x * len;
+        f32 hy = (f32)hdir.y * len;
+        f32 hax = (f32)(-hdir.y) * 6.0f;
+        f32 hay = (f32)(hdir.x) * 6.0f;
+
+        SDL_SetRenderDrawColor(g_api.context, 0, 255, 255, 255);  // cyan
+        SDL_RenderLine(g_api.context, hint_x - hx, center_y - hy, hint_x + hx, center_y + hy);
+        SDL_RenderLine(g_api.context, hint_x + hx, center_y + hy, hint_x + hx*0.5f + hax, center_y + hy*0.5f + hay);
+        SDL_RenderLine(g_api.context, hint_x + hx, center_y + hy, hint_x + hx*0.5f - hax, center_y + hy*0.5f - hay);
+    }
+
     // Render solid walls
     SDL_SetRenderDrawColor(g_api.context, EXPAND_COLOR(WALL_COLOR_INDEX));
     f32 cell_size = 32;
@@ -552,6 +837,11 @@ void grav_draw(f32 dt) {
         SDL_FRect r { (x+ox)*cell_size, (y+oy)*cell_size, cell_size-5, cell_size-5 };
         SDL_RenderFillRect(g_api.context, &r);
     }
+    for (i32 i = 0; i < lvl->num_fixed_crates; i++) {
+        auto [x, y] = lvl->fixed_crates[i];
+        SDL_FRect r { x*cell_size, y*cell_size, cell_size-5, cell_size-5 };
+        SDL_RenderFillRect(g_api.context, &r);
+    }
 
     for (i32 i = 0; i < att->num_gems; i++) {
         if (!((att->gems_active >> i) & 1)) continue;
@@ -566,7 +856,38 @@ void grav_draw(f32 dt) {
     //TODO: Could also look into baking the background once and reusing it with one copy operation per frame
 }
 
+// Everything a tick can change, for replays to check they took the same path. Attempt
+// start times are wall clock and left out.
+u64 grav_state_checksum() {
+    u64 h = 14695981039346656037ull;
+    auto fnv = [&](const void *data, u64 size) {
+        const u8 *bytes = (const u8 *)data;
+        for (u64 i = 0; i < size; i++) {
+            h ^= bytes[i];
+            h *= 1099511628211ull;
+        }
+    };
+
+    fnv(&g_s->phase, sizeof(g_s->phase));
+    fnv(&g_hint_dir, sizeof(g_hint_dir));
+    fnv(g_match.level_indices, sizeof(i8) * g_match.num_players);
+    for (i32 i = 0; i < g_match.num_players * g_match.num_levels; i++) {
+        attempt *att = &g_match.attempts[i];
+        fnv(att->crates, sizeof(ivec2) * att->num_crates);
+        fnv(att->gems, sizeof(ivec2) * att->num_gems);
+        fnv(att->crate_offsets, sizeof(vec2) * att->num_crates);
+        fnv(att->gem_offsets, sizeof(vec2) * att->num_gems);
+        fnv(att->moves, sizeof(direction) * att->num_moves);
+        fnv(&att->current_gravity, sizeof(att->current_gravity));
+        fnv(&att->gems_active, sizeof(att->gems_active));
+        fnv(&att->num_moves, sizeof(att->num_moves));
+        fnv(&att->animating, sizeof(att->animating));
+    }
+    return h;
+}
+
 void grav_exit() {
+    g_api.bus_remove_channel(g_api.bus, &g_gravity_changed);
     match_close(&g_match);
     g_api.config_free(&g_cfg);
 }
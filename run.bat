@@ -1,5 +1,5 @@
 @echo off
 
 pushd bin
-qg.exe
+qg.exe %*
 popd
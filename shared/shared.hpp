@@ -6,15 +6,26 @@
 enum class event_type : u16;
 struct event_bus;
 struct handler_id;
+struct timer_id;
+struct bus_channel_base;
 typedef void (*event_handler_fn)(event_type, void*, void*);
 #define BUS_MODULE_DEF \
     X(void, bus_init, (event_bus*, u64)) \
     X(void, bus_free, (event_bus*)) \
     X(handler_id, bus_subscribe, (event_bus*, event_type, event_handler_fn, void*)) \
+    X(handler_id, bus_subscribe_subject, (event_bus*, event_type, u32, event_handler_fn, void*)) \
     X(bool, bus_unsubscribe, (event_bus*, handler_id)) \
     X(bool, bus_fire, (event_bus*, event_type, const void*, u32)) \
+    X(bool, bus_fire_subject, (event_bus*, event_type, u32, const void*, u32)) \
+    X(bool, bus_fire_async, (event_bus*, event_type, const void*, u32)) \
+    X(void, bus_async_release, (event_bus*)) \
+    X(timer_id, bus_fire_at, (event_bus*, u64, event_type, const void*, u32)) \
+    X(timer_id, bus_fire_after, (event_bus*, u64, event_type, const void*, u32)) \
+    X(bool, bus_cancel_timer, (event_bus*, timer_id)) \
     X(void, bus_process, (event_bus*)) \
-    X(void, bus_reset, (event_bus*))
+    X(void, bus_reset, (event_bus*)) \
+    X(bool, bus_add_channel, (event_bus*, bus_channel_base*)) \
+    X(bool, bus_remove_channel, (event_bus*, bus_channel_base*))
 
 enum class value_type : u8;
 struct config_value;
@@ -41,10 +52,12 @@ struct arena_off;
     X(void*, qg_realloc, (void*, u64)) \
     X(void, qg_free, (void*)) \
     X(void, mem_arena_init, (mem_arena*, u64)) \
+    X(void, mem_arena_init_virtual, (mem_arena*, u64, u64)) \
     X(void, mem_arena_reset, (mem_arena*)) \
     X(void, mem_arena_clear, (mem_arena*)) \
     X(arena_ptr, mem_arena_alloc, (mem_arena*, u64, u64)) \
-    X(arena_off, mem_arena_offloc, (mem_arena*, u64, u64))
+    X(arena_off, mem_arena_offloc, (mem_arena*, u64, u64)) \
+    X(void, mem_arena_track, (mem_arena*, const char*))
 
 struct strview;
 #define PARSE_MODULE_DEF \
@@ -92,10 +105,12 @@ extern "C" void GRAV_API grav_init(engine_api engine);
 extern "C" void GRAV_API grav_tick(f32 dt);
 extern "C" void GRAV_API grav_draw(f32 dt);
 extern "C" void GRAV_API grav_exit();
+extern "C" u64  GRAV_API grav_state_checksum();
 
 #define GAME_MODULE_DEF \
     X(u64,  game_state_size, "grav_state_size", (void)) \
     X(void, game_init,       "grav_init",       (engine_api)) \
     X(void, game_tick,       "grav_tick",       (float)) \
     X(void, game_draw,       "grav_draw",       (float)) \
-    X(void, game_exit,       "grav_exit",       (void))
+    X(void, game_exit,       "grav_exit",       (void)) \
+    X(u64,  game_state_checksum, "grav_state_checksum", (void))
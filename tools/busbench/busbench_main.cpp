@@ -0,0 +1,475 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include "shared_types.hpp"
+#include "qg_bus.hpp"
+
+// busbench: footprint and throughput of the engine event bus, driven only through the
+// public bus_* API. The init/dispatch/churn sections build against older versions of
+// qg_bus.cpp too; the channel, subject and timer sections and the -s stress test need the API they exercise.
+// config.xml builds it with -DNDEBUG, so the numbers are for the bus without its debug
+// instrumentation (BUS_STATS), which times every handler call.
+
+#define BUSBENCH_ARENA_SIZE (1024 * 1024)
+#define BUSBENCH_INIT_REPS 2000
+#define BUSBENCH_CHURN_REPS 1000000
+#define BUSBENCH_TIMER_DELAYS 4096   // Scheduled delays spread over 1..4096 ticks
+
+struct busbench_args {
+    i32 frames;
+    i32 types;
+    i32 handlers;       // Per type, 0 = run 1 and 4
+    i32 payload;        // Event data bytes
+    i32 producers;      // Stress test threads, 0 = run the benchmark
+    i32 stress_events;  // Per producer
+};
+
+struct busbench_payload {
+    u8 bytes[64];
+};
+
+typedef std::chrono::steady_clock::time_point busbench_time;
+
+static inline busbench_time busbench_now() {
+    return std::chrono::steady_clock::now();
+}
+
+static inline f64 busbench_seconds_since(busbench_time start) {
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void busbench_count(event_type type, void* data, void* user_data) {
+    (void)type;
+    u64* calls = (u64*)user_data;
+    *calls += 1 + ((u8*)data)[0];
+}
+
+static void busbench_parse(busbench_args* args, int argc, char** argv) {
+    args->frames = 2000;
+    args->types = 8;
+    args->handlers = 0;
+    args->payload = 16;
+    args->producers = 0;
+    args->stress_events = 200000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            args->frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            args->types = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            args->handlers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            args->payload = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            args->producers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            args->stress_events = atoi(argv[++i]);
+        } else {
+            printf("Usage: busbench.exe [options]\n");
+            printf("  -f <count>   Frames of %d events (default: 2000)\n", BUS_MAX_EVENTS_PER_FRAME);
+            printf("  -t <count>   Event types fired round-robin (default: 8)\n");
+            printf("  -h <count>   Handlers per type (default: 1 and 4)\n");
+            printf("  -p <bytes>   Event payload size (default: 16)\n");
+            printf("  -s <count>   Stress bus_fire_async with <count> producer threads instead\n");
+            printf("  -e <count>   Events per producer for -s (default: 200000)\n");
+        }
+    }
+    if (args->frames < 1) args->frames = 1;
+    if (args->types < 1) args->types = 1;
+    if (args->payload < 1) args->payload = 1;
+    if (args->payload > (i32)sizeof(busbench_payload)) args->payload = (i32)sizeof(busbench_payload);
+}
+
+static void busbench_init(event_bus* bus) {
+    busbench_time t = busbench_now();
+    for (i32 i = 0; i < BUSBENCH_INIT_REPS; i++) {
+        bus_init(bus, BUSBENCH_ARENA_SIZE);
+        bus_free(bus);
+    }
+    f64 seconds = busbench_seconds_since(t);
+
+    printf("footprint  sizeof(event_bus) %llu bytes\n", (u64)sizeof(event_bus));
+    printf("init       %8.2f us/bus_init (+ arena malloc/free)\n", seconds * 1e6 / BUSBENCH_INIT_REPS);
+}
+
+static void busbench_dispatch(event_bus* bus, busbench_args* args, i32 handlers) {
+    bus_init(bus, BUSBENCH_ARENA_SIZE);
+
+    u64 calls = 0;
+    i32 subscribed = 0;
+    for (i32 t = 0; t < args->types; t++) {
+        event_type type = (event_type)((u16)event_type::GAME_EVENTS_START + t);
+        for (i32 h = 0; h < handlers; h++) {
+            if (bus_subscribe(bus, type, busbench_count, &calls).packed != 0) subscribed++;
+        }
+    }
+
+    busbench_payload payload = {};
+    u64 events = 0;
+    busbench_time t = busbench_now();
+    for (i32 f = 0; f < args->frames; f++) {
+        for (i32 e = 0; e < BUS_MAX_EVENTS_PER_FRAME; e++) {
+            event_type type = (event_type)((u16)event_type::GAME_EVENTS_START + e % args->types);
+            if (bus_fire(bus, type, &payload, (u32)args->payload)) events++;
+        }
+        bus_process(bus);
+    }
+    f64 seconds = busbench_seconds_since(t);
+    bus_free(bus);
+
+    u64 expected = events * (u64)subscribed / (u64)args->types;
+    printf("dispatch   %d types x %d handlers: %8.2f M events/s  %6.1f ns/event  (%llu calls%s)\n",
+           args->types, handlers, events / seconds / 1e6, seconds * 1e9 / events, calls,
+           calls == expected ? "" : ", MISMATCH");
+}
+
+// Every 8th frame fires 16x BUS_MAX_EVENTS_PER_FRAME events into a bus whose first payload
+// page is one BUS_PAGE_SIZE: nothing may be dropped, and once the first burst has grown the
+// queue and the pages, later frames must not allocate
+static void busbench_burst(event_bus* bus, busbench_args* args) {
+    bus_init(bus, BUS_PAGE_SIZE);
+    u64 calls = 0;
+    event_type type = event_type::GAME_EVENTS_START;
+    bus_subscribe(bus, type, busbench_count, &calls);
+
+    busbench_payload payload = {};
+    u64 events = 0;
+    u64 dropped = 0;
+    u32 pages_after_first = 0;
+    u32 capacity_after_first = 0;
+    busbench_time t = busbench_now();
+    for (i32 f = 0; f < args->frames; f++) {
+        i32 count = f % 8 == 0 ? BUS_MAX_EVENTS_PER_FRAME * 16 : BUS_MAX_EVENTS_PER_FRAME / 4;
+        for (i32 e = 0; e < count; e++) {
+            if (bus_fire(bus, type, &payload, (u32)args->payload)) events++;
+            else dropped++;
+        }
+        bus_process(bus);
+        if (f == 0) {
+            pages_after_first = bus->num_pages;
+            capacity_after_first = BUS_MAX_EVENTS_PER_FRAME + bus->overflow_capacity;
+        }
+    }
+    f64 seconds = busbench_seconds_since(t);
+    bool grew_later = bus->num_pages != pages_after_first || BUS_MAX_EVENTS_PER_FRAME + bus->overflow_capacity != capacity_after_first;
+
+    printf("burst      %8.2f M events/s  peak frame %u events / %llu payload bytes, %u pages, queue %u%s\n",
+           events / seconds / 1e6, bus->peak_events, bus->peak_payload_bytes, bus->num_pages, BUS_MAX_EVENTS_PER_FRAME + bus->overflow_capacity,
+           dropped == 0 && calls == events && !grew_later ? "" : "  (FAILED)");
+    bus_free(bus);
+}
+
+struct busbench_small_event {
+    i8 player_index;
+    u8 old_dir;
+    u8 new_dir;
+};
+
+static void busbench_count_batch(const busbench_small_event* events, u32 count, void* user_data) {
+    u64* calls = (u64*)user_data;
+    for (u32 i = 0; i < count; i++) *calls += 1 + (u8)events[i].player_index;
+}
+
+// Same small event both ways, one handler: through the queue one event per call, and
+// through a typed channel, one call per frame with every event of the type
+static void busbench_channel(event_bus* bus, busbench_args* args) {
+    static bus_channel<busbench_small_event, BUS_MAX_EVENTS_PER_FRAME> channel;
+    event_type type = event_type::GAME_EVENTS_START;
+    busbench_small_event e = { 0, 1, 2 };
+    u64 events = (u64)args->frames * BUS_MAX_EVENTS_PER_FRAME;
+
+    bus_init(bus, BUSBENCH_ARENA_SIZE);
+    u64 queue_calls = 0;
+    bus_subscribe(bus, type, busbench_count, &queue_calls);
+    busbench_time t = busbench_now();
+    for (i32 f = 0; f < args->frames; f++) {
+        for (i32 i = 0; i < BUS_MAX_EVENTS_PER_FRAME; i++) bus_fire(bus, type, &e, sizeof(e));
+        bus_process(bus);
+    }
+    f64 queue_seconds = busbench_seconds_since(t);
+    bus_free(bus);
+
+    bus_init(bus, BUSBENCH_ARENA_SIZE);
+    u64 channel_calls = 0;
+    channel_init(&channel, type);
+    channel_subscribe(&channel, busbench_count_batch, &channel_calls);
+    bus_add_channel(bus, &channel);
+    t = busbench_now();
+    for (i32 f = 0; f < args->frames; f++) {
+        for (i32 i = 0; i < BUS_MAX_EVENTS_PER_FRAME; i++) channel_fire(&channel, e);
+        bus_process(bus);
+    }
+    f64 channel_seconds = busbench_seconds_since(t);
+    bus_free(bus);
+
+    printf("channel    %d-byte event, queue %8.2f M events/s  channel %8.2f M events/s  %.1fx%s\n",
+           (i32)sizeof(e), events / queue_seconds / 1e6, events / channel_seconds / 1e6,
+           queue_seconds / channel_seconds, queue_calls == events && channel_calls == events ? "" : "  (MISMATCH)");
+}
+
+#define BUSBENCH_PLAYERS 8
+#define BUSBENCH_PLAYER_HANDLERS 2   // Per player (panel, audio), fills BUS_MAX_HANDLERS_PER_TYPE
+
+struct busbench_player_handler {
+    i8 player_index;
+    u64 calls;    // Events for this player
+    u64 misses;   // Filtered broadcast calls for another player, or misrouted subject calls
+};
+
+static void busbench_player_filter(event_type type, void* data, void* user_data) {
+    (void)type;
+    busbench_player_handler* h = (busbench_player_handler*)user_data;
+    if (((busbench_small_event*)data)->player_index != h->player_index) {
+        h->misses++;
+        return;
+    }
+    h->calls++;
+}
+
+static void busbench_player_subject(event_type type, void* data, void* user_data) {
+    (void)type;
+    busbench_player_handler* h = (busbench_player_handler*)user_data;
+    if (((busbench_small_event*)data)->player_index != h->player_index) h->misses++;
+    h->calls++;
+}
+
+// Per-player events with every player's handlers on the type: each one filtering a broadcast,
+// then each one subscribed to its player as the subject
+static void busbench_subject(event_bus* bus, busbench_args* args) {
+    const i32 num_handlers = BUSBENCH_PLAYERS * BUSBENCH_PLAYER_HANDLERS;
+    busbench_player_handler handlers[2][num_handlers] = {};
+    event_type type = event_type::GAME_EVENTS_START;
+    u64 events = (u64)args->frames * BUS_MAX_EVENTS_PER_FRAME;
+    f64 seconds[2];
+
+    for (i32 keyed = 0; keyed < 2; keyed++) {
+        bus_init(bus, BUSBENCH_ARENA_SIZE);
+        for (i32 i = 0; i < num_handlers; i++) {
+            busbench_player_handler* h = &handlers[keyed][i];
+            h->player_index = (i8)(i % BUSBENCH_PLAYERS);
+            if (keyed) {
+                bus_subscribe_subject(bus, type, (u32)h->player_index, busbench_player_subject, h);
+            } else {
+                bus_subscribe(bus, type, busbench_player_filter, h);
+            }
+        }
+
+        busbench_time t = busbench_now();
+        for (i32 f = 0; f < args->frames; f++) {
+            for (i32 i = 0; i < BUS_MAX_EVENTS_PER_FRAME; i++) {
+                busbench_small_event e = { (i8)(i % BUSBENCH_PLAYERS), 1, 2 };
+                if (keyed) {
+                    bus_fire_subject(bus, type, (u32)e.player_index, &e, sizeof(e));
+                } else {
+                    bus_fire(bus, type, &e, sizeof(e));
+                }
+            }
+            bus_process(bus);
+        }
+        seconds[keyed] = busbench_seconds_since(t);
+        bus_free(bus);
+    }
+
+    u64 calls[2] = {};
+    u64 misses[2] = {};
+    for (i32 keyed = 0; keyed < 2; keyed++) {
+        for (i32 i = 0; i < num_handlers; i++) {
+            calls[keyed] += handlers[keyed][i].calls;
+            misses[keyed] += handlers[keyed][i].misses;
+        }
+    }
+    bool ok = calls[0] == events * BUSBENCH_PLAYER_HANDLERS && calls[1] == calls[0] && misses[1] == 0;
+
+    printf("subject    %d players x %d handlers, broadcast %8.2f M events/s (%llu calls)  subject %8.2f M events/s (%llu calls)  %.1fx%s\n",
+           BUSBENCH_PLAYERS, BUSBENCH_PLAYER_HANDLERS, events / seconds[0] / 1e6, calls[0] + misses[0],
+           events / seconds[1] / 1e6, calls[1], seconds[0] / seconds[1], ok ? "" : "  (MISMATCH)");
+}
+
+static void busbench_churn(event_bus* bus) {
+    bus_init(bus, BUSBENCH_ARENA_SIZE);
+
+    // A few resident handlers so unsubscribing has neighbours to keep in order
+    u64 calls = 0;
+    event_type type = event_type::GAME_EVENTS_START;
+    for (i32 h = 0; h < 4; h++) bus_subscribe(bus, type, busbench_count, &calls);
+
+    i32 failures = 0;
+    busbench_time t = busbench_now();
+    for (i32 i = 0; i < BUSBENCH_CHURN_REPS; i++) {
+        handler_id id = bus_subscribe(bus, type, busbench_count, &calls);
+        if (!bus_unsubscribe(bus, id) || bus_unsubscribe(bus, id)) failures++;
+    }
+    f64 seconds = busbench_seconds_since(t);
+    bus_free(bus);
+
+    printf("churn      %8.1f ns/subscribe+unsubscribe%s\n", seconds * 1e9 / BUSBENCH_CHURN_REPS,
+           failures == 0 ? "" : "  (stale handler_id accepted)");
+}
+
+struct busbench_timer_state {
+    event_bus* bus;
+    u64 fired;
+    u64 failures;
+};
+
+// Every fired timer schedules itself again with the delay it carries
+static void busbench_timer_fired(event_type type, void* data, void* user_data) {
+    busbench_timer_state* state = (busbench_timer_state*)user_data;
+    u64 delay;
+    memcpy(&delay, data, sizeof(delay));
+    state->fired++;
+    if (!bus_fire_after(state->bus, delay, type, &delay, sizeof(delay)).packed) state->failures++;
+}
+
+// Schedule+cancel pairs, then a steady state of BUS_MAX_TIMERS timers with delays spread
+// over every wheel level they can reach, run for -f * 8 ticks
+static void busbench_timers(event_bus* bus, busbench_args* args) {
+    event_type type = event_type::GAME_EVENTS_START;
+    bus_init(bus, BUSBENCH_ARENA_SIZE);
+
+    i32 failures = 0;
+    busbench_time t = busbench_now();
+    for (i32 i = 0; i < BUSBENCH_CHURN_REPS; i++) {
+        u64 delay = (u64)i * 7919 % BUSBENCH_TIMER_DELAYS + 1;
+        timer_id id = bus_fire_after(bus, delay, type, &delay, sizeof(delay));
+        if (!bus_cancel_timer(bus, id) || bus_cancel_timer(bus, id)) failures++;
+    }
+    f64 cancel_seconds = busbench_seconds_since(t);
+
+    busbench_timer_state state = { bus, 0, 0 };
+    bus_subscribe(bus, type, busbench_timer_fired, &state);
+    for (u64 i = 0; i < BUS_MAX_TIMERS; i++) {
+        u64 delay = (i * 7919) % BUSBENCH_TIMER_DELAYS + 1;
+        if (!bus_fire_after(bus, delay, type, &delay, sizeof(delay)).packed) state.failures++;
+    }
+
+    i32 ticks = args->frames * 8;
+    t = busbench_now();
+    for (i32 i = 0; i < ticks; i++) bus_process(bus);
+    f64 tick_seconds = busbench_seconds_since(t);
+    bus_free(bus);
+
+    printf("timers     %8.1f ns/schedule+cancel  %d pending: %8.1f ns/tick  %8.2f M fired/s%s\n",
+           cancel_seconds * 1e9 / BUSBENCH_CHURN_REPS, BUS_MAX_TIMERS, tick_seconds * 1e9 / ticks,
+           state.fired / tick_seconds / 1e6, failures == 0 && state.failures == 0 ? "" : "  (FAILED)");
+}
+
+// Stress test payload: who fired it, its place in that producer's sequence, and a check
+// value, so the consumer can spot reordering, loss, duplication and torn payloads
+struct busbench_stress_event {
+    u32 producer;
+    u32 seq;
+    u64 check;
+};
+
+struct busbench_stress_state {
+    std::vector<u32> next_seq;  // Expected seq per producer
+    u64 received;
+    u64 errors;
+};
+
+static inline u64 busbench_stress_check(u32 producer, u32 seq) {
+    return ((u64)producer << 32 | seq) * 0x9E3779B97F4A7C15ull;
+}
+
+static void busbench_stress_handler(event_type type, void* data, void* user_data) {
+    (void)type;
+    busbench_stress_state* st = (busbench_stress_state*)user_data;
+    busbench_stress_event* e = (busbench_stress_event*)data;
+
+    bool ok = e->producer < st->next_seq.size() && e->seq == st->next_seq[e->producer] &&
+              e->check == busbench_stress_check(e->producer, e->seq);
+    if (ok) {
+        st->next_seq[e->producer]++;
+    } else {
+        st->errors++;
+    }
+    st->received++;
+}
+
+static void busbench_stress_producer(event_bus* bus, u32 producer, i32 count, u64* retries) {
+    u64 busy = 0;
+    for (i32 i = 0; i < count; i++) {
+        busbench_stress_event e = { producer, (u32)i, busbench_stress_check(producer, (u32)i) };
+        while (!bus_fire_async(bus, event_type::GAME_EVENTS_START, &e, sizeof(e))) {
+            busy++;
+            std::this_thread::yield();
+        }
+    }
+    bus_async_release(bus);
+    *retries = busy;
+}
+
+// Producers fire flat out while the main thread runs bus_process like a frame loop.
+// Every producer's events must arrive complete and in the order it fired them.
+static i32 busbench_stress(event_bus* bus, busbench_args* args) {
+    bus_init(bus, BUSBENCH_ARENA_SIZE);
+
+    busbench_stress_state st;
+    st.next_seq.assign(args->producers, 0);
+    st.received = 0;
+    st.errors = 0;
+    bus_subscribe(bus, event_type::GAME_EVENTS_START, busbench_stress_handler, &st);
+
+    u64 expected = (u64)args->producers * (u64)args->stress_events;
+    std::vector<u64> retries(args->producers, 0);
+    std::vector<std::thread> threads;
+
+    busbench_time t = busbench_now();
+    for (i32 i = 0; i < args->producers; i++) {
+        threads.emplace_back(busbench_stress_producer, bus, (u32)i, args->stress_events, &retries[i]);
+    }
+
+    u64 frames = 0;
+    while (st.received < expected) {
+        bus_process(bus);
+        frames++;
+        std::this_thread::yield();
+        if (busbench_seconds_since(t) > 60.0) break;
+    }
+    for (std::thread& th : threads) th.join();
+    bus_process(bus);
+    f64 seconds = busbench_seconds_since(t);
+    bus_free(bus);
+
+    u64 busy = 0;
+    for (u64 r : retries) busy += r;
+    bool ok = st.received == expected && st.errors == 0;
+    printf("stress     %d producers x %d events: %8.2f M events/s  %llu frames  %llu full retries\n",
+           args->producers, args->stress_events, st.received / seconds / 1e6, frames, busy);
+    printf("           received %llu/%llu  errors %llu  %s\n", st.received, expected, st.errors,
+           ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    busbench_args args;
+    busbench_parse(&args, argc, argv);
+
+    event_bus* bus = (event_bus*)qg_calloc(1, sizeof(event_bus));
+    if (args.producers > 0) {
+        i32 result = busbench_stress(bus, &args);
+        qg_free(bus);
+        return result;
+    }
+
+    busbench_init(bus);
+    if (args.handlers > 0) {
+        busbench_dispatch(bus, &args, args.handlers);
+    } else {
+        busbench_dispatch(bus, &args, 1);
+        busbench_dispatch(bus, &args, 4);
+    }
+    busbench_burst(bus, &args);
+    busbench_channel(bus, &args);
+    busbench_subject(bus, &args);
+    busbench_churn(bus);
+    busbench_timers(bus, &args);
+    qg_free(bus);
+    return 0;
+}
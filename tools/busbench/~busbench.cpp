@@ -0,0 +1,5 @@
+// Engine modules (SDL-free)
+#include "../../engine/qg_memory.cpp"
+#include "../../engine/qg_bus.cpp"
+
+#include "busbench_main.cpp"
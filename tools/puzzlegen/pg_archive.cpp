@@ -0,0 +1,410 @@
+#include <vector>
+
+// Corpus archive (.pga): many levels in far less than 108 bytes each. Levels are
+// bit-packed with only what they use: dimensions, element counts, 2-bit colors,
+// positions as a cell index of just enough bits for width * height, and the wall map
+// without its (always solid) border. Interior walls are stored either raw or as
+// Elias-gamma gaps between solid cells, whichever is shorter for that level.
+//
+// Levels are grouped into chunks that start on a byte boundary and share no state,
+// so every chunk decodes on its own and archive_read spreads them over a job_pool.
+//
+// Decoding a level and writing it with level_write_binary gives back exactly the
+// record level_write_binary made from the original. The encoder checks this for
+// every level and stores the raw 108-byte record instead if it does not hold
+// (elements outside the board, stray bits past width * height).
+//
+// File layout (little endian):
+//   u32 magic ('G85A')
+//   u16 version
+//   u16 reserved
+//   u32 num_levels
+//   u32 num_chunks
+//   per chunk:
+//     u64 offset            from the start of the file
+//     u32 size              bytes
+//     u32 num_levels
+//   chunk data
+//
+// Per level, LSB first:
+//   1  raw                  1 = 108-byte record follows, nothing else below
+//   4  width - 1, 4 height - 1, 3 start_gravity
+//   6  num_crates, 6 num_gems
+//   2  color per gem
+//   b  cell index per crate, then per gem, b = bits for width * height
+//   1  border                1 = every border cell solid and omitted below
+//   1  gaps                  0 = one bit per remaining cell, 1 = gap coding:
+//        b                   number of solid cells
+//        gamma(gap + 1)      empty cells before each solid cell
+
+#define ARCHIVE_MAGIC 0x41353847u // "G85A"
+#define ARCHIVE_VERSION 2 // 2: dimensions stored minus one, so 16 fits
+#define ARCHIVE_DEFAULT_CHUNK_LEVELS 4096
+
+struct archive_chunk_entry {
+    u64 offset;
+    u32 size;
+    u32 num_levels;
+};
+
+struct bit_writer {
+    std::vector<u8> *out;
+    u64 acc;
+    i32 bits;
+};
+
+struct bit_reader {
+    const u8 *p;
+    const u8 *end;
+    u64 acc;
+    i32 bits;
+};
+
+static void bits_put(bit_writer *w, u32 value, i32 n) {
+    w->acc |= (u64)(value & ((1ull << n) - 1)) << w->bits;
+    w->bits += n;
+    while (w->bits >= 8) {
+        w->out->push_back((u8)w->acc);
+        w->acc >>= 8;
+        w->bits -= 8;
+    }
+}
+
+static void bits_flush(bit_writer *w) {
+    if (w->bits > 0) w->out->push_back((u8)w->acc);
+    w->acc = 0;
+    w->bits = 0;
+}
+
+// Tops the accumulator up to at least 57 bits; past the end of the data it reads zeros
+static inline void bits_refill(bit_reader *r) {
+    while (r->bits <= 56) {
+        u64 byte = r->p < r->end ? *r->p++ : 0;
+        r->acc |= byte << r->bits;
+        r->bits += 8;
+    }
+}
+
+static inline u32 bits_get(bit_reader *r, i32 n) {
+    if (r->bits < n) bits_refill(r);
+    u32 v = (u32)(r->acc & ((1ull << n) - 1));
+    r->acc >>= n;
+    r->bits -= n;
+    return v;
+}
+
+static void bits_put_gamma(bit_writer *w, u32 v) {
+    i32 n = 0;
+    while ((v >> (n + 1)) != 0) n++;
+    bits_put(w, 0, n);
+    bits_put(w, 1, 1);
+    bits_put(w, v, n);
+}
+
+static u32 bits_get_gamma(bit_reader *r) {
+    if (r->bits < 32) bits_refill(r);
+    i32 n = 0;
+    while (n < 31 && !((r->acc >> n) & 1)) n++;
+    r->acc >>= n + 1;
+    r->bits -= n + 1;
+    return (1u << n) | bits_get(r, n);
+}
+
+// Bits for a value in [0, count)
+static i32 archive_index_bits(i32 count) {
+    i32 b = 0;
+    while ((1 << b) < count) b++;
+    return b;
+}
+
+static bool archive_is_border(level *lvl, i32 x, i32 y) {
+    return x == 0 || y == 0 || x == lvl->width - 1 || y == lvl->height - 1;
+}
+
+static void archive_encode_compact(bit_writer *w, level *lvl) {
+    i32 cells = lvl->width * lvl->height;
+    i32 ib = archive_index_bits(cells);
+
+    bits_put(w, 0, 1);
+    bits_put(w, lvl->width - 1, 4);
+    bits_put(w, lvl->height - 1, 4);
+    bits_put(w, (u32)lvl->start_gravity, 3);
+    bits_put(w, lvl->num_crates, 6);
+    bits_put(w, lvl->num_gems, 6);
+    for (i32 i = 0; i < lvl->num_gems; i++) bits_put(w, (u32)lvl->gem_colors[i], 2);
+    for (i32 i = 0; i < lvl->num_crates; i++) bits_put(w, lvl->crate_starts[i].y * lvl->width + lvl->crate_starts[i].x, ib);
+    for (i32 i = 0; i < lvl->num_gems; i++) bits_put(w, lvl->gem_starts[i].y * lvl->width + lvl->gem_starts[i].x, ib);
+
+    bool border = true;
+    for (i32 y = 0; y < lvl->height && border; y++) {
+        for (i32 x = 0; x < lvl->width; x++) {
+            if (archive_is_border(lvl, x, y) && !level_is_solid(lvl, { x, y })) { border = false; break; }
+        }
+    }
+    bits_put(w, border, 1);
+
+    // Cells left to store, row-major
+    bool solid[MAP_MAX_SIZE];
+    i32 num_cells = 0, num_solid = 0;
+    for (i32 y = 0; y < lvl->height; y++) {
+        for (i32 x = 0; x < lvl->width; x++) {
+            if (border && archive_is_border(lvl, x, y)) continue;
+            solid[num_cells] = level_is_solid(lvl, { x, y });
+            num_solid += solid[num_cells];
+            num_cells++;
+        }
+    }
+
+    // Gap cost, raw costs num_cells
+    i32 cb = archive_index_bits(num_cells + 1);
+    i32 gap_bits = cb;
+    for (i32 i = 0, gap = 0; i < num_cells; i++) {
+        if (!solid[i]) { gap++; continue; }
+        i32 n = 0;
+        while (((u32)(gap + 1) >> (n + 1)) != 0) n++;
+        gap_bits += 2 * n + 1;
+        gap = 0;
+    }
+
+    bool gaps = gap_bits < num_cells;
+    bits_put(w, gaps, 1);
+    if (!gaps) {
+        for (i32 i = 0; i < num_cells; i++) bits_put(w, solid[i], 1);
+        return;
+    }
+    bits_put(w, num_solid, cb);
+    for (i32 i = 0, gap = 0; i < num_cells; i++) {
+        if (!solid[i]) { gap++; continue; }
+        bits_put_gamma(w, gap + 1);
+        gap = 0;
+    }
+}
+
+static void archive_decode_level(bit_reader *r, level *lvl) {
+    memset(lvl, 0, sizeof(level));
+    if (bits_get(r, 1)) {
+        u8 data[LEVEL_FILE_SIZE];
+        for (i32 i = 0; i < LEVEL_FILE_SIZE; i++) data[i] = (u8)bits_get(r, 8);
+        level_read_binary(data, lvl);
+        return;
+    }
+
+    lvl->width = (i8)(bits_get(r, 4) + 1);
+    lvl->height = (i8)(bits_get(r, 4) + 1);
+    lvl->start_gravity = (direction)bits_get(r, 3);
+    lvl->num_crates = (i8)bits_get(r, 6);
+    lvl->num_gems = (i8)bits_get(r, 6);
+
+    // Cell indices stay below 256, where a 16-bit reciprocal divides exactly by any width up to 16
+    u32 w = (u32)lvl->width;
+    u32 recip = (65536 + w - 1) / w;
+    i32 ib = archive_index_bits(lvl->width * lvl->height);
+    for (i32 i = 0; i < lvl->num_gems; i++) lvl->gem_colors[i] = (color)bits_get(r, 2);
+    for (i32 i = 0; i < lvl->num_crates; i++) {
+        u32 idx = bits_get(r, ib);
+        u32 y = (idx * recip) >> 16;
+        lvl->crate_starts[i] = { (i32)(idx - y * w), (i32)y };
+    }
+    for (i32 i = 0; i < lvl->num_gems; i++) {
+        u32 idx = bits_get(r, ib);
+        u32 y = (idx * recip) >> 16;
+        lvl->gem_starts[i] = { (i32)(idx - y * w), (i32)y };
+    }
+
+    bool border = bits_get(r, 1);
+    bool gaps = bits_get(r, 1);
+
+    // Stored cells form an inner_w x inner_h block at (off, off), row-major
+    i32 off = border ? 1 : 0;
+    i32 inner_w = lvl->width - 2 * off;
+    i32 inner_h = lvl->height - 2 * off;
+    i32 num_cells = inner_w > 0 && inner_h > 0 ? inner_w * inner_h : 0;
+    auto set_solid = [lvl](i32 x, i32 y) {
+        u32 idx = y * lvl->width + x;
+        lvl->solid[idx / 8] |= (u8)(1 << (idx % 8));
+    };
+
+    if (border) {
+        for (i32 x = 0; x < lvl->width; x++) { set_solid(x, 0); set_solid(x, lvl->height - 1); }
+        for (i32 y = 1; y < lvl->height - 1; y++) { set_solid(0, y); set_solid(lvl->width - 1, y); }
+    }
+
+    if (!gaps) {
+        for (i32 y = 0; y < inner_h && num_cells > 0; y++) {
+            u32 row = bits_get(r, inner_w);
+            for (i32 x = 0; row; x++, row >>= 1) {
+                if (row & 1) set_solid(off + x, off + y);
+            }
+        }
+        return;
+    }
+
+    i32 num_solid = (i32)bits_get(r, archive_index_bits(num_cells + 1));
+    for (i32 i = 0, k = -1; i < num_solid; i++) {
+        k += (i32)bits_get_gamma(r);
+        if (k >= num_cells) break;
+        i32 y = k / inner_w;
+        set_solid(off + k - y * inner_w, off + y);
+    }
+}
+
+// Appends one level, compact if it decodes back to the same record, raw otherwise
+static void archive_encode_level(bit_writer *w, level *lvl) {
+    u8 expect[LEVEL_FILE_SIZE];
+    level_write_binary(lvl, expect);
+
+    // Check on a scratch writer so a failed attempt leaves nothing behind
+    std::vector<u8> scratch;
+    bit_writer sw = { &scratch, 0, 0 };
+    archive_encode_compact(&sw, lvl);
+    bits_flush(&sw);
+
+    bit_reader r = { scratch.data(), scratch.data() + scratch.size(), 0, 0 };
+    level decoded;
+    archive_decode_level(&r, &decoded);
+    u8 got[LEVEL_FILE_SIZE];
+    level_write_binary(&decoded, got);
+
+    if (memcmp(expect, got, LEVEL_FILE_SIZE) == 0) {
+        archive_encode_compact(w, lvl);
+        return;
+    }
+    bits_put(w, 1, 1);
+    for (i32 i = 0; i < LEVEL_FILE_SIZE; i++) bits_put(w, expect[i], 8);
+}
+
+void archive_encode_chunk(level *levels, i32 count, std::vector<u8> *out) {
+    bit_writer w = { out, 0, 0 };
+    for (i32 i = 0; i < count; i++) archive_encode_level(&w, &levels[i]);
+    bits_flush(&w);
+}
+
+void archive_decode_chunk(const u8 *data, u32 size, i32 count, level *out) {
+    bit_reader r = { data, data + size, 0, 0 };
+    for (i32 i = 0; i < count; i++) archive_decode_level(&r, &out[i]);
+}
+
+// Written under <path>.tmp and moved over path once complete, a failed write leaves any
+// existing archive as it was
+bool archive_write(level *levels, i32 count, const char *path, i32 chunk_levels = ARCHIVE_DEFAULT_CHUNK_LEVELS) {
+    if (chunk_levels <= 0) chunk_levels = ARCHIVE_DEFAULT_CHUNK_LEVELS;
+    u32 num_chunks = (u32)((count + chunk_levels - 1) / chunk_levels);
+
+    std::vector<u8> data;
+    std::vector<archive_chunk_entry> entries(num_chunks);
+    u64 header_size = 16 + (u64)num_chunks * sizeof(archive_chunk_entry);
+    for (u32 c = 0; c < num_chunks; c++) {
+        i32 first = (i32)c * chunk_levels;
+        i32 n = count - first < chunk_levels ? count - first : chunk_levels;
+        entries[c].offset = header_size + data.size();
+        archive_encode_chunk(levels + first, n, &data);
+        entries[c].size = (u32)(header_size + data.size() - entries[c].offset);
+        entries[c].num_levels = (u32)n;
+    }
+
+    char tmp_path[260];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *f;
+    i32 err = fopen_s(&f, tmp_path, "wb");
+    if (err != 0 || !f) return false;
+
+    u32 magic = ARCHIVE_MAGIC;
+    u16 version = ARCHIVE_VERSION;
+    u16 reserved = 0;
+    u32 num_levels = (u32)count;
+    bool ok = fwrite(&magic, sizeof(magic), 1, f) == 1
+           && fwrite(&version, sizeof(version), 1, f) == 1
+           && fwrite(&reserved, sizeof(reserved), 1, f) == 1
+           && fwrite(&num_levels, sizeof(num_levels), 1, f) == 1
+           && fwrite(&num_chunks, sizeof(num_chunks), 1, f) == 1;
+    for (u32 c = 0; c < num_chunks && ok; c++) {
+        ok = fwrite(&entries[c].offset, sizeof(u64), 1, f) == 1
+          && fwrite(&entries[c].size, sizeof(u32), 1, f) == 1
+          && fwrite(&entries[c].num_levels, sizeof(u32), 1, f) == 1;
+    }
+    if (ok && !data.empty()) ok = fwrite(data.data(), data.size(), 1, f) == 1;
+    ok = !ferror(f) && ok;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || !file_replace(tmp_path, path)) {
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+struct archive_read_job {
+    const u8 *file;
+    archive_chunk_entry *entries;
+    u64 *first_level;
+    level *levels;
+};
+
+static void archive_read_chunk_job(void *user, i32 /*worker*/, i32 index) {
+    archive_read_job *job = (archive_read_job *)user;
+    archive_chunk_entry *e = &job->entries[index];
+    archive_decode_chunk(job->file + e->offset, e->size, (i32)e->num_levels, job->levels + job->first_level[index]);
+}
+
+// Reads the whole archive and decodes its chunks over num_threads workers (0 = one per
+// hardware thread). *levels is malloc'd; free it with free().
+bool archive_read(const char *path, level **levels, i32 *count, i32 num_threads = 0) {
+    *levels = nullptr;
+    *count = 0;
+
+    FILE *f;
+    i32 err = fopen_s(&f, path, "rb");
+    if (err != 0 || !f) return false;
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (file_size < 16) { fclose(f); return false; }
+
+    u8 *file = (u8 *)malloc(file_size);
+    bool ok = fread(file, file_size, 1, f) == 1;
+    fclose(f);
+
+    u32 magic, num_levels, num_chunks;
+    u16 version;
+    memcpy(&magic, file, sizeof(u32));
+    memcpy(&version, file + 4, sizeof(u16));
+    memcpy(&num_levels, file + 8, sizeof(u32));
+    memcpy(&num_chunks, file + 12, sizeof(u32));
+    ok = ok && magic == ARCHIVE_MAGIC && version == ARCHIVE_VERSION
+            && 16 + (u64)num_chunks * sizeof(archive_chunk_entry) <= (u64)file_size;
+
+    std::vector<archive_chunk_entry> entries;
+    std::vector<u64> first_level;
+    u64 total = 0;
+    for (u32 c = 0; c < num_chunks && ok; c++) {
+        archive_chunk_entry e;
+        const u8 *p = file + 16 + (u64)c * sizeof(archive_chunk_entry);
+        memcpy(&e.offset, p, sizeof(u64));
+        memcpy(&e.size, p + 8, sizeof(u32));
+        memcpy(&e.num_levels, p + 12, sizeof(u32));
+        ok = e.offset + e.size <= (u64)file_size;
+        entries.push_back(e);
+        first_level.push_back(total);
+        total += e.num_levels;
+    }
+    if (!ok || total != num_levels) {
+        free(file);
+        return false;
+    }
+
+    level *out = (level *)malloc(sizeof(level) * (num_levels > 0 ? num_levels : 1));
+    archive_read_job job = { file, entries.data(), first_level.data(), out };
+    if (num_chunks > 1) {
+        job_pool *pool = new job_pool();
+        jobs_init(pool, num_threads);
+        jobs_run(pool, (i32)num_chunks, archive_read_chunk_job, &job);
+        jobs_shutdown(pool);
+        delete pool;
+    } else if (num_chunks == 1) {
+        archive_read_chunk_job(&job, 0, 0);
+    }
+
+    free(file);
+    *levels = out;
+    *count = (i32)num_levels;
+    return true;
+}
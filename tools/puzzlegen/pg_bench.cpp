@@ -0,0 +1,452 @@
+// Scalar vs bitboard comparison on one generated corpus (puzzlegen -B <count>).
+// Measures successor expansion on its own (expand + hash every successor of a fixed
+// sample of states) and end-to-end solving, and checks both paths agree.
+
+#define BENCH_STATES_PER_LEVEL 2000
+#define BENCH_MAX_STATES 200000
+
+// First states of a plain BFS from the level start, as expansion input
+static void bench_sample_states(level *lvl, std::vector<sim_state> *out) {
+    std::unordered_set<u64> seen;
+    size_t first = out->size();
+
+    sim_state start;
+    sim_init(&start, lvl);
+    out->push_back(start);
+    seen.insert(sim_state_hash(&start));
+
+    for (size_t i = first; i < out->size() && out->size() - first < BENCH_STATES_PER_LEVEL; i++) {
+        for (i32 d = 0; d < 4; d++) {
+            sim_state next = (*out)[i];
+            if ((direction)d == next.current_gravity) continue;
+            sim_apply_move(&next, lvl, (direction)d);
+            if (sim_is_solved(&next) || !seen.insert(sim_state_hash(&next)).second) continue;
+            out->push_back(next);
+        }
+    }
+}
+
+void bench_expand_run(config *cfg, i64 seed, i32 count, i32 max_solve_moves) {
+    gen_params gp;
+    gen_params_from_config(&gp, cfg);
+    rand_seed(seed);
+
+    // Corpus: reduced levels, like the solvers see them
+    std::vector<level> corpus;
+    i32 attempts = 0;
+    while ((i32)corpus.size() < count && attempts < count * 100) {
+        attempts++;
+        level lvl, reduced;
+        if (!gen_random_level(&lvl, &gp) || !gen_filter_level(&lvl)) continue;
+        level_reduce(&lvl, &reduced);
+        corpus.push_back(reduced);
+    }
+    printf("bench: %d levels (seed=%lld)\n", (i32)corpus.size(), seed);
+
+    std::vector<sim_state> states;
+    std::vector<u32> state_level;
+    for (u32 i = 0; i < corpus.size(); i++) {
+        bench_sample_states(&corpus[i], &states);
+        state_level.resize(states.size(), i);
+    }
+
+    std::vector<bb_level> bb_levels(corpus.size());
+    for (u32 i = 0; i < corpus.size(); i++) bb_level_init(&bb_levels[i], &corpus[i]);
+    std::vector<bb_state> bb_states(states.size());
+    for (size_t i = 0; i < states.size(); i++) bb_state_from_sim(&bb_states[i], &states[i]);
+
+    // Expansion only: every non-trivial successor of every sampled state, hashed
+    u64 checksum = 0;
+    u64 scalar_succ = 0;
+    stats_time t = stats_now();
+    for (size_t i = 0; i < states.size(); i++) {
+        level *lvl = &corpus[state_level[i]];
+        for (i32 d = 0; d < 4; d++) {
+            if ((direction)d == states[i].current_gravity) continue;
+            sim_state next = states[i];
+            sim_apply_move(&next, lvl, (direction)d);
+            checksum += sim_state_hash(&next);
+            scalar_succ++;
+        }
+    }
+    f64 scalar_expand = stats_seconds_since(t);
+
+    u64 bb_succ = 0;
+    t = stats_now();
+    for (size_t i = 0; i < bb_states.size(); i++) {
+        bb_state succ[4];
+        direction moves[4];
+        i32 n = bb_expand(&bb_levels[state_level[i]], &bb_states[i], succ, moves);
+        for (i32 k = 0; k < n; k++) checksum += bb_state_hash(&succ[k]);
+        bb_succ += n;
+    }
+    f64 bb_expand_time = stats_seconds_since(t);
+
+    printf("expand: %llu states\n", (u64)states.size());
+    printf("  scalar   %8.3f ms  %7.1f ns/state  %llu successors hashed\n",
+           scalar_expand * 1000.0, scalar_expand * 1e9 / states.size(), scalar_succ);
+    printf("  bitboard %8.3f ms  %7.1f ns/state  %llu successors hashed (%llu no-ops skipped)\n",
+           bb_expand_time * 1000.0, bb_expand_time * 1e9 / states.size(), bb_succ, scalar_succ - bb_succ);
+    printf("  speedup  %.2fx  (checksum %llx)\n", scalar_expand / bb_expand_time, checksum);
+
+    // End to end
+    i32 mismatches = 0;
+    i64 scalar_states = 0, bb_states_explored = 0;
+    f64 scalar_solve = 0.0, bb_solve = 0.0;
+    for (level &lvl : corpus) {
+        t = stats_now();
+        solve_result a = solver_solve(&lvl, max_solve_moves, BENCH_MAX_STATES);
+        scalar_solve += stats_seconds_since(t);
+
+        t = stats_now();
+        solve_result b = solver_solve_bitboard(&lvl, max_solve_moves, BENCH_MAX_STATES);
+        bb_solve += stats_seconds_since(t);
+
+        scalar_states += a.states_explored;
+        bb_states_explored += b.states_explored;
+        bool limited = a.stop == solve_stop::STATE_LIMIT || b.stop == solve_stop::STATE_LIMIT;
+        if (!limited && (a.solvable != b.solvable || a.optimal_moves != b.optimal_moves)) mismatches++;
+    }
+
+    printf("solve: max_states=%d\n", BENCH_MAX_STATES);
+    printf("  scalar   %8.3f s  %10lld states  %9.0f states/s\n",
+           scalar_solve, scalar_states, scalar_states / scalar_solve);
+    printf("  bitboard %8.3f s  %10lld states  %9.0f states/s\n",
+           bb_solve, bb_states_explored, bb_states_explored / bb_solve);
+    printf("  speedup  %.2fx  mismatches %d\n", scalar_solve / bb_solve, mismatches);
+}
+
+// Novelty index scaling (puzzlegen -N <count>): feeds <count> generated levels through
+// novelty_accept, like the main loop does, and reports query cost as the index grows
+// against a linear scan over the same entries. Features leave out the solution shape,
+// so nothing is solved.
+#define BENCH_NOVELTY_SAMPLES 100
+
+void bench_novelty_run(config *cfg, i64 seed, i32 count) {
+    gen_params gp;
+    gen_params_from_config(&gp, cfg);
+    novelty_params np;
+    novelty_params_from_config(&np, cfg);
+    if (np.min_distance <= 0.0f) np.min_distance = 0.1f;
+    rand_seed(seed);
+
+    novelty_index *idx = new novelty_index();
+    novelty_init(idx, &np);
+    printf("bench: novelty min_distance=%.3f tables=%d projections=%d (seed=%lld)\n",
+           np.min_distance, np.num_tables, np.num_projections, seed);
+    printf("%10s %10s %12s %12s %12s %10s %8s\n",
+           "levels", "entries", "lsh us/q", "cand/q", "linear us/q", "rejected", "recall");
+
+    i32 rejected = 0;
+    i32 checkpoint = 1000;
+    f64 lsh_seconds = 0.0;
+    u64 checked_before = 0, queries_before = 0;
+
+    i32 n = 0;
+    for (i32 attempts = 0; n < count && attempts < count * 100; attempts++) {
+        level lvl;
+        if (!gen_random_level(&lvl, &gp) || !gen_filter_level(&lvl)) continue;
+        f32 v[NOVELTY_DIMS];
+        novelty_features(&lvl, nullptr, v);
+        n++;
+
+        stats_time t = stats_now();
+        if (!novelty_accept(idx, v)) rejected++;
+        lsh_seconds += stats_seconds_since(t);
+        if (n != checkpoint && n != count) continue;
+
+        f64 lsh_us = lsh_seconds * 1e6 / (idx->queries - queries_before);
+        f64 cand = (f64)(idx->candidates_checked - checked_before) / (idx->queries - queries_before);
+
+        // Fresh probes, answered exactly by a linear scan and approximately by the index
+        i32 found = 0, expected = 0, probes = 0;
+        f64 linear_seconds = 0.0;
+        for (i32 tries = 0; probes < BENCH_NOVELTY_SAMPLES && tries < BENCH_NOVELTY_SAMPLES * 100; tries++) {
+            if (!gen_random_level(&lvl, &gp) || !gen_filter_level(&lvl)) continue;
+            f32 q[NOVELTY_DIMS];
+            novelty_features(&lvl, nullptr, q);
+            probes++;
+
+            stats_time lt = stats_now();
+            f32 exact = FLT_MAX;
+            for (u32 e = 0; e < idx->count; e++) {
+                f32 d = novelty_distance(q, &idx->vectors[(size_t)e * NOVELTY_DIMS]);
+                if (d < exact) exact = d;
+            }
+            linear_seconds += stats_seconds_since(lt);
+
+            if (exact < np.min_distance) {
+                expected++;
+                if (novelty_nearest(idx, q) < np.min_distance) found++;
+            }
+        }
+
+        printf("%10d %10u %12.2f %12.1f %12.2f %10d %7.1f%%\n", n, idx->count, lsh_us, cand,
+               probes ? linear_seconds * 1e6 / probes : 0.0, rejected,
+               expected ? 100.0 * found / expected : 100.0);
+
+        checkpoint *= 10;
+        lsh_seconds = 0.0;
+        checked_before = idx->candidates_checked;
+        queries_before = idx->queries;
+    }
+    if (n < count) printf("WARNING: only %d of %d levels passed the generator filters\n", n, count);
+
+    novelty_free(idx);
+    delete idx;
+}
+
+// Corpus archive vs raw 108-byte records (puzzlegen -A <count>): size, load time and an
+// exact round trip through level_write_binary for every level.
+void bench_archive_run(config *cfg, i64 seed, i32 count, const char *dir) {
+    gen_params gp;
+    gen_params_from_config(&gp, cfg);
+    rand_seed(seed);
+
+    std::vector<level> corpus;
+    i32 attempts = 0;
+    while ((i32)corpus.size() < count && attempts < count * 100) {
+        attempts++;
+        level lvl;
+        if (!gen_random_level(&lvl, &gp) || !gen_filter_level(&lvl)) continue;
+        corpus.push_back(lvl);
+    }
+    if ((i32)corpus.size() < count) {
+        printf("WARNING: only %d of %d levels passed the generator filters\n", (i32)corpus.size(), count);
+        count = (i32)corpus.size();
+        if (count == 0) return;
+    }
+
+    _mkdir(dir);
+    char raw_path[256], archive_path[256];
+    snprintf(raw_path, sizeof(raw_path), "%s/bench_corpus.bin", dir);
+    snprintf(archive_path, sizeof(archive_path), "%s/bench_corpus.pga", dir);
+
+    std::vector<u8> raw((size_t)count * LEVEL_FILE_SIZE);
+    for (i32 i = 0; i < count; i++) level_write_binary(&corpus[i], &raw[(size_t)i * LEVEL_FILE_SIZE]);
+    FILE *f;
+    if (fopen_s(&f, raw_path, "wb") != 0 || !f) {
+        printf("ERROR: Could not write %s\n", raw_path);
+        return;
+    }
+    fwrite(raw.data(), raw.size(), 1, f);
+    fclose(f);
+
+    stats_time t = stats_now();
+    bool written = archive_write(corpus.data(), count, archive_path);
+    f64 encode_seconds = stats_seconds_since(t);
+    if (!written) {
+        printf("ERROR: Could not write %s\n", archive_path);
+        return;
+    }
+
+    // Raw load: one read, then level_read_binary per record
+    t = stats_now();
+    std::vector<level> raw_levels(count);
+    std::vector<u8> raw_in((size_t)count * LEVEL_FILE_SIZE);
+    if (fopen_s(&f, raw_path, "rb") == 0 && f) {
+        fread(raw_in.data(), raw_in.size(), 1, f);
+        fclose(f);
+    }
+    for (i32 i = 0; i < count; i++) level_read_binary(&raw_in[(size_t)i * LEVEL_FILE_SIZE], &raw_levels[i]);
+    f64 raw_seconds = stats_seconds_since(t);
+
+    t = stats_now();
+    level *loaded = nullptr;
+    i32 loaded_count = 0;
+    bool read = archive_read(archive_path, &loaded, &loaded_count);
+    f64 archive_seconds = stats_seconds_since(t);
+
+    i32 mismatches = read ? 0 : count;
+    for (i32 i = 0; read && i < count; i++) {
+        u8 got[LEVEL_FILE_SIZE];
+        level_write_binary(&loaded[i], got);
+        if (i >= loaded_count || memcmp(got, &raw[(size_t)i * LEVEL_FILE_SIZE], LEVEL_FILE_SIZE) != 0) mismatches++;
+    }
+    free(loaded);
+
+    FILE *af;
+    u64 archive_bytes = 0;
+    if (fopen_s(&af, archive_path, "rb") == 0 && af) {
+        fseek(af, 0, SEEK_END);
+        archive_bytes = (u64)ftell(af);
+        fclose(af);
+    }
+    u64 raw_bytes = raw.size();
+
+    printf("bench: archive %d levels (seed=%lld)\n", count, seed);
+    printf("  raw      %10llu bytes  %6.1f B/level  load %8.3f ms\n",
+           raw_bytes, (f64)raw_bytes / count, raw_seconds * 1000.0);
+    printf("  archive  %10llu bytes  %6.1f B/level  load %8.3f ms  encode %8.3f ms\n",
+           archive_bytes, (f64)archive_bytes / count, archive_seconds * 1000.0, encode_seconds * 1000.0);
+    printf("  ratio    %.2fx  mismatches %d\n", (f64)raw_bytes / archive_bytes, mismatches);
+}
+
+// Bulk column decode vs level_read_binary per record (puzzlegen -D <count>), plus a
+// typical analysis pass (gems per color) over each layout.
+void bench_columns_run(config *cfg, i64 seed, i32 count) {
+    gen_params gp;
+    gen_params_from_config(&gp, cfg);
+    rand_seed(seed);
+
+    std::vector<u8> records((size_t)count * LEVEL_FILE_SIZE);
+    i32 n = 0;
+    for (i32 attempts = 0; n < count && attempts < count * 100; attempts++) {
+        level lvl;
+        if (!gen_random_level(&lvl, &gp) || !gen_filter_level(&lvl)) continue;
+        level_write_binary(&lvl, &records[(size_t)n * LEVEL_FILE_SIZE]);
+        n++;
+    }
+    if (n < count) {
+        printf("WARNING: only %d of %d levels passed the generator filters\n", n, count);
+        count = n;
+        if (count == 0) return;
+    }
+
+    std::vector<level> levels(count);
+    stats_time t = stats_now();
+    for (i32 i = 0; i < count; i++) level_read_binary(&records[(size_t)i * LEVEL_FILE_SIZE], &levels[i]);
+    f64 aos_decode = stats_seconds_since(t);
+
+    // Both sides decode into memory that has been touched already, like std::vector's zero fill
+    level_columns cols;
+    level_columns_init(&cols, count);
+    level_columns_decode(&cols, records.data(), count);
+    cols.count = 0;
+    t = stats_now();
+    level_columns_decode(&cols, records.data(), count);
+    f64 soa_decode = stats_seconds_since(t);
+
+    i32 mismatches = 0;
+    for (i32 i = 0; i < count; i++) {
+        level lvl;
+        level_columns_get(&cols, i, &lvl);
+        u8 a[LEVEL_FILE_SIZE];
+        level_write_binary(&lvl, a);
+        if (memcmp(a, &records[(size_t)i * LEVEL_FILE_SIZE], LEVEL_FILE_SIZE) != 0) mismatches++;
+    }
+
+    u64 aos_hist[4] = {}, soa_hist[4] = {};
+    t = stats_now();
+    for (i32 i = 0; i < count; i++) {
+        for (i32 g = 0; g < levels[i].num_gems; g++) aos_hist[(i32)levels[i].gem_colors[g] & 3]++;
+    }
+    f64 aos_scan = stats_seconds_since(t);
+
+    t = stats_now();
+    for (i32 i = 0; i < count; i++) {
+        const u8 *colors = cols.gem_colors + (u64)i * ELEMENTS_MAX_NUM;
+        for (i32 g = 0; g < cols.num_gems[i]; g++) soa_hist[colors[g] & 3]++;
+    }
+    f64 soa_scan = stats_seconds_since(t);
+    level_columns_free(&cols);
+
+    printf("bench: column decode %d levels (seed=%lld)\n", count, seed);
+    printf("  decode  aos %8.3f ms (%6.1f ns/level)  soa %8.3f ms (%6.1f ns/level)  %.2fx\n",
+           aos_decode * 1000.0, aos_decode * 1e9 / count, soa_decode * 1000.0, soa_decode * 1e9 / count,
+           aos_decode / soa_decode);
+    printf("  scan    aos %8.3f ms  soa %8.3f ms  %.2fx  (gems per color %llu/%llu/%llu)\n",
+           aos_scan * 1000.0, soa_scan * 1000.0, aos_scan / soa_scan, soa_hist[0], soa_hist[1], soa_hist[2]);
+    bool same = memcmp(aos_hist, soa_hist, sizeof(aos_hist)) == 0;
+    printf("  mismatches %d%s\n", mismatches, same ? "" : "  (histograms differ)");
+}
+
+// Per-file bundle_write against one pack through the background writer, count bundles each.
+// Bundles cycle over a small set of generated levels; only the output side is timed.
+void bench_writer_run(config *cfg, i64 seed, i32 count, const char *dir) {
+    gen_params gp;
+    gen_params_from_config(&gp, cfg);
+    rand_seed(seed);
+
+    bundle samples[16];
+    i32 attempts = 0;
+    for (i32 s = 0; s < 16; s++) {
+        for (i32 i = 0; i < 5; ) {
+            if (attempts++ >= 16 * 5 * 100) {
+                printf("ERROR: Could not generate %d sample levels\n", 16 * 5);
+                return;
+            }
+            level lvl;
+            if (!gen_random_level(&lvl, &gp) || !gen_filter_level(&lvl)) continue;
+            samples[s].levels[i] = lvl;
+            samples[s].difficulty_scores[i] = rand_float01();
+            samples[s].optimal_moves[i] = rand_int_min(1, SOLVER_MAX_MOVES);
+            i++;
+        }
+    }
+
+    char files_dir[256], path[256], meta[256];
+    snprintf(files_dir, sizeof(files_dir), "%s/bench_files", dir);
+    _mkdir(dir);
+    _mkdir(files_dir);
+
+    i32 failures = 0;
+    stats_time t = stats_now();
+    for (i32 n = 0; n < count; n++) {
+        snprintf(path, sizeof(path), "%s/bundle_%03d.bin", files_dir, n);
+        snprintf(meta, sizeof(meta), "%s/bundle_%03d.txt", files_dir, n);
+        if (!bundle_write(&samples[n % 16], path, meta)) failures++;
+    }
+    f64 files_time = stats_seconds_since(t);
+
+    char pack_path[256], pack_meta[256];
+    snprintf(pack_path, sizeof(pack_path), "%s/bench_pack.bin", dir);
+    snprintf(pack_meta, sizeof(pack_meta), "%s/bench_pack.txt", dir);
+    batch_writer *bin = new batch_writer();
+    batch_writer *txt = new batch_writer();
+    t = stats_now();
+    bool bin_open = batch_writer_open(bin, pack_path);
+    bool txt_open = batch_writer_open(txt, pack_meta);
+    if (bin_open && txt_open) {
+        batch_writer_printf(txt, "# Bundle metadata\n");
+        for (i32 n = 0; n < count; n++) bundle_pack_append(bin, txt, &samples[n % 16], n);
+        if (!batch_writer_close(bin)) failures++;
+        if (!batch_writer_close(txt)) failures++;
+    } else {
+        // Failed writers drop their .tmp on close, like pg_main's pack output
+        printf("ERROR: Could not open %s\n", bin_open ? pack_meta : pack_path);
+        if (bin_open) { bin->failed = true; batch_writer_close(bin); }
+        if (txt_open) { txt->failed = true; batch_writer_close(txt); }
+        delete bin;
+        delete txt;
+        return;
+    }
+    f64 pack_time = stats_seconds_since(t);
+    delete bin;
+    delete txt;
+
+    // Every bundle in the pack must match its standalone file byte for byte
+    i32 mismatches = 0;
+    FILE *pf;
+    if (fopen_s(&pf, pack_path, "rb") == 0 && pf) {
+        for (i32 n = 0; n < count; n++) {
+            u8 a[5 * LEVEL_FILE_SIZE], b[5 * LEVEL_FILE_SIZE];
+            snprintf(path, sizeof(path), "%s/bundle_%03d.bin", files_dir, n);
+            FILE *f;
+            bool same = fread(a, sizeof(a), 1, pf) == 1 && fopen_s(&f, path, "rb") == 0 && f;
+            if (same) {
+                same = fread(b, sizeof(b), 1, f) == 1 && memcmp(a, b, sizeof(a)) == 0;
+                fclose(f);
+            }
+            if (!same) mismatches++;
+        }
+        fclose(pf);
+    } else {
+        mismatches = count;
+    }
+
+    for (i32 n = 0; n < count; n++) {
+        snprintf(path, sizeof(path), "%s/bundle_%03d.bin", files_dir, n);
+        snprintf(meta, sizeof(meta), "%s/bundle_%03d.txt", files_dir, n);
+        remove(path);
+        remove(meta);
+    }
+    _rmdir(files_dir);
+
+    printf("bench: bundle output %d bundles (seed=%lld)\n", count, seed);
+    printf("  files %8.2f ms (%6.1f us/bundle, %d files)\n",
+           files_time * 1000.0, files_time * 1e6 / count, count * 2);
+    printf("  pack  %8.2f ms (%6.1f us/bundle, 2 files)  %.1fx\n",
+           pack_time * 1000.0, pack_time * 1e6 / count, files_time / pack_time);
+    printf("  failures %d  mismatches %d\n", failures, mismatches);
+}
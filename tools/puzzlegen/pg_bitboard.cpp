@@ -0,0 +1,321 @@
+#include <emmintrin.h>
+
+// Bitboard simulation: the board is a set of 16x16 bit planes (walls, crates, one per
+// gem color), one u16 per row, held in two SSE2 registers (rows 0-7 and 8-15). A
+// gravity step moves every element whose next cell is free at once, repeated until
+// nothing moves, which settles each lane exactly like the sorted serial slide in
+// pg_sim.cpp. A gem is part of a combo iff a same-color gem sits next to it, so a
+// whole combo pass is four shifts and an AND per color.
+//
+// Same-color gems and crates are interchangeable on a plane, so bb_state is already
+// canonical and hashes directly. bb_expand settles all successors of a state in one
+// interleaved loop and drops moves that leave the board unchanged before hashing.
+
+struct bb_board {
+    __m128i lo;     // Rows 0-7
+    __m128i hi;     // Rows 8-15
+};
+
+#define BB_NUM_PLANES 4 // Crates + 3 gem colors
+
+struct bb_state {
+    bb_board planes[BB_NUM_PLANES];
+    direction gravity;
+};
+
+struct bb_level {
+    bb_board walls;     // Includes everything outside width x height
+};
+
+static inline bb_board bb_zero() {
+    return { _mm_setzero_si128(), _mm_setzero_si128() };
+}
+
+static inline bb_board bb_or(bb_board a, bb_board b) {
+    return { _mm_or_si128(a.lo, b.lo), _mm_or_si128(a.hi, b.hi) };
+}
+
+static inline bb_board bb_and(bb_board a, bb_board b) {
+    return { _mm_and_si128(a.lo, b.lo), _mm_and_si128(a.hi, b.hi) };
+}
+
+static inline bb_board bb_andnot(bb_board a, bb_board b) { // ~a & b
+    return { _mm_andnot_si128(a.lo, b.lo), _mm_andnot_si128(a.hi, b.hi) };
+}
+
+static inline bb_board bb_xor(bb_board a, bb_board b) {
+    return { _mm_xor_si128(a.lo, b.lo), _mm_xor_si128(a.hi, b.hi) };
+}
+
+static inline bool bb_empty(bb_board a) {
+    __m128i v = _mm_or_si128(a.lo, a.hi);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+}
+
+static inline bool bb_equal(bb_board a, bb_board b) {
+    return bb_empty(bb_xor(a, b));
+}
+
+// Moves every bit one cell along dir; bits leaving the 16x16 area are dropped
+static inline bb_board bb_shift(bb_board b, direction dir) {
+    switch (dir) {
+        case direction::UP:
+            return { _mm_or_si128(_mm_srli_si128(b.lo, 2), _mm_slli_si128(b.hi, 14)), _mm_srli_si128(b.hi, 2) };
+        case direction::DOWN:
+            return { _mm_slli_si128(b.lo, 2), _mm_or_si128(_mm_slli_si128(b.hi, 2), _mm_srli_si128(b.lo, 14)) };
+        case direction::RIGHT:
+            return { _mm_slli_epi16(b.lo, 1), _mm_slli_epi16(b.hi, 1) };
+        case direction::LEFT:
+            return { _mm_srli_epi16(b.lo, 1), _mm_srli_epi16(b.hi, 1) };
+        default:
+            return b;
+    }
+}
+
+static inline direction bb_opposite(direction dir) {
+    return (direction)(((u8)dir + 2) % 4);
+}
+
+static inline void bb_set(bb_board *b, ivec2 p) {
+    alignas(16) u16 rows[16];
+    _mm_store_si128((__m128i *)&rows[0], b->lo);
+    _mm_store_si128((__m128i *)&rows[8], b->hi);
+    rows[p.y] |= (u16)(1u << p.x);
+    b->lo = _mm_load_si128((__m128i *)&rows[0]);
+    b->hi = _mm_load_si128((__m128i *)&rows[8]);
+}
+
+void bb_level_init(bb_level *out, level *lvl) {
+    alignas(16) u16 rows[16];
+    for (i32 y = 0; y < 16; y++) {
+        rows[y] = 0xFFFF;
+        if (y >= lvl->height) continue;
+        for (i32 x = 0; x < lvl->width; x++) {
+            if (!level_is_solid(lvl, { x, y })) rows[y] &= (u16)~(1u << x);
+        }
+    }
+    out->walls.lo = _mm_load_si128((__m128i *)&rows[0]);
+    out->walls.hi = _mm_load_si128((__m128i *)&rows[8]);
+}
+
+void bb_state_from_sim(bb_state *out, sim_state *s) {
+    for (i32 i = 0; i < BB_NUM_PLANES; i++) out->planes[i] = bb_zero();
+    for (i32 i = 0; i < s->num_crates; i++) bb_set(&out->planes[0], s->crates[i]);
+    for (i32 i = 0; i < s->num_gems; i++) {
+        if ((s->gems_active >> i) & 1) bb_set(&out->planes[1 + (i32)s->gem_colors[i]], s->gems[i]);
+    }
+    out->gravity = s->current_gravity;
+}
+
+static inline bb_board bb_occupied(bb_state *s) {
+    return bb_or(bb_or(s->planes[0], s->planes[1]), bb_or(s->planes[2], s->planes[3]));
+}
+
+static inline bool bb_board_equal(bb_state *a, bb_state *b) {
+    bb_board diff = bb_zero();
+    for (i32 i = 0; i < BB_NUM_PLANES; i++) diff = bb_or(diff, bb_xor(a->planes[i], b->planes[i]));
+    return bb_empty(diff);
+}
+
+bool bb_is_solved(bb_state *s) {
+    return bb_empty(bb_or(bb_or(s->planes[1], s->planes[2]), s->planes[3]));
+}
+
+// One parallel gravity step; false once nothing can move
+static inline bool bb_step(bb_level *lvl, bb_state *s) {
+    bb_board free_cells = bb_andnot(bb_or(lvl->walls, bb_occupied(s)), { _mm_set1_epi8(-1), _mm_set1_epi8(-1) });
+    bb_board can_move = bb_shift(free_cells, bb_opposite(s->gravity)); // Bit at p: p + dir is free
+
+    bb_board any = bb_zero();
+    for (i32 i = 0; i < BB_NUM_PLANES; i++) {
+        bb_board moving = bb_and(s->planes[i], can_move);
+        s->planes[i] = bb_or(bb_xor(s->planes[i], moving), bb_shift(moving, s->gravity));
+        any = bb_or(any, moving);
+    }
+    return !bb_empty(any);
+}
+
+// Clears every gem touching a same-color gem; false if nothing matched
+static inline bool bb_combos(bb_state *s) {
+    bb_board cleared = bb_zero();
+    for (i32 c = 1; c < BB_NUM_PLANES; c++) {
+        bb_board g = s->planes[c];
+        bb_board adjacent = bb_or(bb_or(bb_shift(g, direction::UP), bb_shift(g, direction::DOWN)),
+                                  bb_or(bb_shift(g, direction::LEFT), bb_shift(g, direction::RIGHT)));
+        bb_board matched = bb_and(g, adjacent);
+        s->planes[c] = bb_xor(g, matched);
+        cleared = bb_or(cleared, matched);
+    }
+    return !bb_empty(cleared);
+}
+
+// Same result as sim_apply_move
+void bb_apply_move(bb_level *lvl, bb_state *s, direction dir) {
+    s->gravity = dir;
+    while (bb_step(lvl, s)) {}
+    while (bb_combos(s)) {
+        while (bb_step(lvl, s)) {}
+    }
+}
+
+// Writes every successor worth hashing to out[] and its move to moves[], returns the count.
+// Skips the current gravity, and moves that leave the board untouched when the parent is
+// already settled: such a child only offers moves the parent has, one level deeper.
+i32 bb_expand(bb_level *lvl, bb_state *parent, bb_state out[4], direction moves[4]) {
+    i32 n = 0;
+    for (i32 d = 0; d < 4; d++) {
+        if ((direction)d == parent->gravity) continue;
+        out[n] = *parent;
+        out[n].gravity = (direction)d;
+        moves[n] = (direction)d;
+        n++;
+    }
+
+    // Settle all successors in lockstep so their independent steps overlap
+    bool active[4] = { true, true, true, true };
+    i32 num_active = n;
+    while (num_active > 0) {
+        num_active = 0;
+        for (i32 i = 0; i < n; i++) {
+            if (!active[i]) continue;
+            active[i] = bb_step(lvl, &out[i]);
+            num_active += active[i];
+        }
+    }
+    for (i32 i = 0; i < n; i++) {
+        while (bb_combos(&out[i])) {
+            while (bb_step(lvl, &out[i])) {}
+        }
+    }
+
+    bool parent_settled = true;
+    if (parent->gravity != direction::COUNT) {
+        bb_state probe = *parent;
+        parent_settled = !bb_step(lvl, &probe);
+    }
+    if (!parent_settled) return n;
+
+    i32 kept = 0;
+    for (i32 i = 0; i < n; i++) {
+        if (bb_board_equal(&out[i], parent)) continue;
+        out[kept] = out[i];
+        moves[kept] = moves[i];
+        kept++;
+    }
+    return kept;
+}
+
+u64 bb_state_hash(bb_state *s) {
+    alignas(16) u64 words[BB_NUM_PLANES * 4];
+    for (i32 i = 0; i < BB_NUM_PLANES; i++) {
+        _mm_store_si128((__m128i *)&words[i * 4 + 0], s->planes[i].lo);
+        _mm_store_si128((__m128i *)&words[i * 4 + 2], s->planes[i].hi);
+    }
+    u64 h = 0x9E3779B97F4A7C15ull ^ (u64)s->gravity;
+    for (i32 i = 0; i < BB_NUM_PLANES * 4; i++) {
+        h = (h ^ words[i]) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+struct bb_frontier_node {
+    bb_state state;
+    u32 id;
+};
+
+// BFS over bb_state with the same contract as solver_solve (no graph stats). Only
+// parent links are kept for every visited state; full boards live in the two
+// frontier layers. Since no-op moves are pruned, states_explored is lower than the
+// scalar solver's while optimal_moves is the same.
+solve_result solver_solve_bitboard(level *lvl, i32 max_depth, i32 max_states, solve_budget *budget = nullptr) {
+    solve_result result = {};
+    solver_time start_time = solver_now();
+    solve_stop depth_stop = solver_depth_cap(&max_depth, budget);
+
+    level reduced;
+    if (!solver_prepare(lvl, &reduced, &result)) return result;
+    lvl = &reduced;
+
+    sim_state start;
+    sim_init(&start, lvl);
+    if (sim_is_solved(&start)) {
+        solver_mark_solved(&result, 0, budget);
+        result.states_explored = 1;
+        result.peak_bytes = sizeof(bb_state);
+        return result;
+    }
+
+    bb_level bl;
+    bb_level_init(&bl, lvl);
+
+    std::unordered_set<u64> visited;
+    std::vector<u32> parents;
+    std::vector<direction> moves;
+    std::vector<bb_frontier_node> layer, next_layer;
+
+    bb_frontier_node root;
+    bb_state_from_sim(&root.state, &start);
+    root.id = 0;
+    visited.insert(bb_state_hash(&root.state));
+    parents.push_back(0);
+    moves.push_back(direction::COUNT);
+    layer.push_back(root);
+
+    result.lower_bound = 1;
+    result.stop = solve_stop::EXHAUSTED;
+
+    i32 depth = 0;
+    while (!layer.empty()) {
+        if (depth + 1 > result.lower_bound) result.lower_bound = depth + 1;
+        if (depth >= max_depth) {
+            result.states_explored += (i32)layer.size();
+            result.stop = depth_stop;
+            break;
+        }
+
+        next_layer.clear();
+        for (bb_frontier_node &node : layer) {
+            if ((i32)visited.size() >= max_states) {
+                result.stop = solve_stop::STATE_LIMIT;
+                break;
+            }
+            u64 mem = visited.size() * (sizeof(u64) + 2 * sizeof(void *)) + visited.bucket_count() * sizeof(void *)
+                    + parents.size() * (sizeof(u32) + sizeof(direction))
+                    + (layer.capacity() + next_layer.capacity()) * sizeof(bb_frontier_node);
+            if (mem > result.peak_bytes) result.peak_bytes = mem;
+            if (solver_over_budget(&result, budget, start_time, result.states_explored)) break;
+            result.states_explored++;
+
+            bb_state succ[4];
+            direction succ_moves[4];
+            i32 n = bb_expand(&bl, &node.state, succ, succ_moves);
+            for (i32 i = 0; i < n; i++) {
+                if (!visited.insert(bb_state_hash(&succ[i])).second) continue;
+
+                u32 id = (u32)parents.size();
+                parents.push_back(node.id);
+                moves.push_back(succ_moves[i]);
+
+                if (bb_is_solved(&succ[i])) {
+                    solver_mark_solved(&result, depth + 1, budget);
+                    result.states_explored++;
+                    for (i32 m = depth; m >= 0; m--) {
+                        result.solution[m] = moves[id];
+                        id = parents[id];
+                    }
+                    result.seconds = solver_seconds_since(start_time);
+                    return result;
+                }
+                next_layer.push_back({ succ[i], id });
+            }
+        }
+        if (result.stop != solve_stop::EXHAUSTED) break;
+
+        layer.swap(next_layer);
+        depth++;
+    }
+
+    result.seconds = solver_seconds_since(start_time);
+    return result;
+}
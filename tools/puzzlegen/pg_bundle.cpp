@@ -2,11 +2,14 @@ struct puzzle_entry {
     level lvl;
     solve_result sol;
     f32 difficulty;
+    f32 features[NOVELTY_DIMS];
 };
 
 struct bundle_tier {
     f32 min_difficulty;
     f32 max_difficulty;
+    i32 min_moves;      // Optional explicit optimal-move window, 0 = derive from the weights
+    i32 max_moves;
 };
 
 void bundle_tier_from_config(bundle_tier *tier, config *cfg, const char *tier_name) {
@@ -22,6 +25,44 @@ void bundle_tier_from_config(bundle_tier *tier, config *cfg, const char *tier_na
         tier->min_difficulty = val.range.min / 100.0f;
         tier->max_difficulty = val.range.max / 100.0f;
     }
+
+    tier->min_moves = 0;
+    tier->max_moves = 0;
+    snprintf(key, sizeof(key), "bundle_moves_%s", tier_name);
+    if (config_read(cfg, key, &val) && val.type == value_type::RANGE) {
+        tier->min_moves = val.range.min;
+        tier->max_moves = val.range.max;
+    }
+}
+
+// Optimal-move range a puzzle can have and still score inside the tier.
+// Conservative: every non-move term is assumed to be at its best (for the lower
+// bound) or worst (for the upper bound) case, so nothing that could land in the
+// tier is rejected. An explicit bundle_moves_<tier> range narrows it further.
+void bundle_tier_move_window(bundle_tier *tier, difficulty_weights *w, i32 max_solve_moves,
+                             i32 *min_moves, i32 *max_moves) {
+    *min_moves = 0;
+    *max_moves = max_solve_moves;
+
+    if (w->moves > 0.0f && max_solve_moves > 1) {
+        // Odd-color bonus adds up to 0.05 per color
+        f32 others = w->gems + w->colors + w->density
+                   + w->branching + w->dead_ends + w->solutions + w->state_space
+                   + w->playout + 0.15f;
+        f32 span = (f32)(max_solve_moves - 1);
+        f32 eps = 1e-4f;
+
+        // move_score = (moves - 1) / span, must reach (min_difficulty - others) / w->moves
+        f32 lo = (tier->min_difficulty - others) / w->moves;
+        if (lo > 0.0f) *min_moves = (i32)ceilf(1.0f + lo * span - eps);
+
+        // move_score alone must not push the score past max_difficulty
+        f32 hi = tier->max_difficulty / w->moves;
+        if (tier->max_difficulty < 1.0f && hi < 1.0f) *max_moves = (i32)floorf(1.0f + hi * span + eps);
+    }
+
+    if (tier->min_moves > *min_moves) *min_moves = tier->min_moves;
+    if (tier->max_moves > 0 && tier->max_moves < *max_moves) *max_moves = tier->max_moves;
 }
 
 // Sort puzzle pool by difficulty (insertion sort)
@@ -37,7 +78,9 @@ void pool_sort_by_difficulty(puzzle_entry *pool, i32 count) {
     }
 }
 
-bool bundle_assemble(bundle *b, puzzle_entry *sorted_pool, i32 pool_count, bundle_tier *tier) {
+// min_distance > 0 keeps near-identical puzzles (novelty_features) out of one bundle
+bool bundle_assemble(bundle *b, puzzle_entry *sorted_pool, i32 pool_count, bundle_tier *tier,
+                     f32 min_distance = 0.0f) {
     // Find puzzles within tier range
     i32 tier_start = -1, tier_end = -1;
     for (i32 i = 0; i < pool_count; i++) {
@@ -55,9 +98,32 @@ bool bundle_assemble(bundle *b, puzzle_entry *sorted_pool, i32 pool_count, bundl
 
     i32 range = tier_end - tier_start + 1;
 
-    // Pick 5 puzzles at evenly spaced slots for escalating difficulty
+    // Pick 5 puzzles at evenly spaced slots for escalating difficulty. With a min_distance,
+    // a slot may move up to just before the next slot's target to find a puzzle unlike the
+    // ones already picked; failing that it takes the most distinct one it saw.
+    i32 picked[5];
     for (i32 slot = 0; slot < 5; slot++) {
         i32 idx = tier_start + (slot * (range - 1)) / 4;
+        if (slot > 0 && idx <= picked[slot - 1]) idx = picked[slot - 1] + 1;
+
+        if (min_distance > 0.0f && slot > 0) {
+            i32 limit = slot < 4 ? tier_start + ((slot + 1) * (range - 1)) / 4 : tier_end + 1;
+            i32 best = idx;
+            f32 best_dist = -1.0f;
+            for (i32 i = idx; i < limit; i++) {
+                f32 nearest = FLT_MAX;
+                for (i32 s = 0; s < slot; s++) {
+                    f32 d = novelty_distance(sorted_pool[i].features, sorted_pool[picked[s]].features);
+                    if (d < nearest) nearest = d;
+                }
+                if (nearest > best_dist) { best = i; best_dist = nearest; }
+                if (nearest >= min_distance) break;
+            }
+            idx = best;
+        }
+        if (idx > tier_end) return false;
+        picked[slot] = idx;
+
         b->levels[slot] = sorted_pool[idx].lvl;
         b->difficulty_scores[slot] = sorted_pool[idx].difficulty;
         b->optimal_moves[slot] = sorted_pool[idx].sol.optimal_moves;
@@ -4,7 +4,8 @@
 #include <cstdlib>
 #include <cstdio>
 
-#define CONFIG_ALLOC_SIZE 1024*2
+// Room for CONFIG_NUM_KEYS entries; puzzlegen.cfg is much longer than the game configs
+#define CONFIG_ALLOC_SIZE 1024*16
 
 void config_init(config *c, const char *file) {
     mem_arena_init(&c->_mem_vals, CONFIG_ALLOC_SIZE);
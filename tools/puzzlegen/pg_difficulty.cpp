@@ -1,8 +1,19 @@
+#include <cmath>
+
 struct difficulty_weights {
     f32 moves;
     f32 gems;
     f32 colors;
     f32 density;
+
+    // State-graph terms, only scored when the solver collected solver_graph_stats
+    f32 branching;
+    f32 dead_ends;
+    f32 solutions;
+    f32 state_space;
+
+    // Monte Carlo term, only scored when a playout_result is provided
+    f32 playout;
 };
 
 void difficulty_weights_from_config(difficulty_weights *w, config *cfg) {
@@ -13,6 +24,21 @@ void difficulty_weights_from_config(difficulty_weights *w, config *cfg) {
     if (config_read(cfg, "weight_gems", &val))   w->gems   = val.integer / 100.0f;
     if (config_read(cfg, "weight_colors", &val)) w->colors = val.integer / 100.0f;
     if (config_read(cfg, "weight_density", &val)) w->density = val.integer / 100.0f;
+
+    w->branching = 0.0f; w->dead_ends = 0.0f; w->solutions = 0.0f; w->state_space = 0.0f;
+
+    if (config_read(cfg, "weight_branching", &val))   w->branching   = val.integer / 100.0f;
+    if (config_read(cfg, "weight_dead_ends", &val))   w->dead_ends   = val.integer / 100.0f;
+    if (config_read(cfg, "weight_solutions", &val))   w->solutions   = val.integer / 100.0f;
+    if (config_read(cfg, "weight_state_space", &val)) w->state_space = val.integer / 100.0f;
+
+    w->playout = 0.0f;
+    if (config_read(cfg, "weight_playout", &val)) w->playout = val.integer / 100.0f;
+}
+
+// True if any weight needs the solver to collect solver_graph_stats
+bool difficulty_weights_use_graph(difficulty_weights *w) {
+    return w->branching > 0.0f || w->dead_ends > 0.0f || w->solutions > 0.0f || w->state_space > 0.0f;
 }
 
 static f32 clamp01(f32 v) { return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v); }
@@ -21,7 +47,8 @@ static f32 normalize(f32 v, f32 lo, f32 hi) {
     return clamp01((v - lo) / (hi - lo));
 }
 
-f32 difficulty_score(level *lvl, solve_result *sol, difficulty_weights *w, i32 max_solve_moves) {
+f32 difficulty_score(level *lvl, solve_result *sol, difficulty_weights *w, i32 max_solve_moves,
+                     solver_graph_stats *gs = nullptr, playout_result *pr = nullptr) {
     f32 move_score = normalize((f32)sol->optimal_moves, 1.0f, (f32)max_solve_moves);
 
     f32 gem_score = normalize((f32)lvl->num_gems, 2.0f, 16.0f);
@@ -52,6 +79,35 @@ f32 difficulty_score(level *lvl, solve_result *sol, difficulty_weights *w, i32 m
               + w->colors * color_score
               + w->density * density_score;
 
+    if (gs) {
+        // More live choices per move means more ways to go wrong
+        f32 branching_score = normalize(gs->branching_factor, 1.0f, 3.0f);
+
+        f32 dead_end_score = normalize(gs->dead_end_ratio, 0.0f, 0.5f);
+
+        // A single optimal line is harder to stumble onto than dozens of them
+        f32 solutions = gs->optimal_solutions > 0 ? (f32)gs->optimal_solutions : 1.0f;
+        f32 solution_score = 1.0f - normalize(log2f(solutions), 0.0f, 8.0f);
+
+        // Widest BFS layer, on a log scale
+        i32 widest = 1;
+        for (i32 d = 0; d <= gs->deepest_layer; d++) {
+            if (gs->states_per_depth[d] > widest) widest = gs->states_per_depth[d];
+        }
+        f32 state_space_score = normalize(log2f((f32)widest), 1.0f, 14.0f);
+
+        score += w->branching * branching_score
+               + w->dead_ends * dead_end_score
+               + w->solutions * solution_score
+               + w->state_space * state_space_score;
+    }
+
+    if (pr) {
+        // Expected resets on a log scale: ~60 resets before a lucky clear saturates the term
+        f32 playout_score = normalize(log2f(1.0f + pr->expected_resets), 0.0f, 6.0f);
+        score += w->playout * playout_score;
+    }
+
     // Odd-color bonus: +0.05 per color with odd count
     for (i32 c = 0; c < 3; c++) {
         if (color_counts[c] > 0 && (color_counts[c] % 2) != 0) {
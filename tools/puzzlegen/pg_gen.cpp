@@ -1,3 +1,13 @@
+// How interior walls are laid out before elements are placed
+enum class wall_mode : u8 {
+    SCATTER,    // Independent random cells; may leave sealed pockets
+    SEALED,     // Scatter, then fill every open region but the largest
+    CARVE,      // Solid interior carved open by a drunkard walk; one connected region
+    COUNT
+};
+
+static const char *wall_mode_names[(u8)wall_mode::COUNT] = { "scatter", "sealed", "carve" };
+
 struct gen_params {
     i32 width_min, width_max;
     i32 height_min, height_max;
@@ -5,6 +15,8 @@ struct gen_params {
     i32 crates_min, crates_max;
     i32 colors_min, colors_max;
     i32 wall_density_min, wall_density_max; // percentage 0-100
+    wall_mode walls;
+    i32 carve_straight;                     // Chance in percent that the carver keeps its heading
 };
 
 void gen_params_from_config(gen_params *p, config *cfg) {
@@ -16,6 +28,8 @@ void gen_params_from_config(gen_params *p, config *cfg) {
     p->crates_min = 0; p->crates_max = 4;
     p->colors_min = 2; p->colors_max = 3;
     p->wall_density_min = 15; p->wall_density_max = 35;
+    p->walls = wall_mode::SCATTER;
+    p->carve_straight = 60;
 
     if (config_read(cfg, "grid_width", &val) && val.type == value_type::RANGE) {
         p->width_min = val.range.min; p->width_max = val.range.max;
@@ -35,6 +49,98 @@ void gen_params_from_config(gen_params *p, config *cfg) {
     if (config_read(cfg, "wall_density", &val) && val.type == value_type::RANGE) {
         p->wall_density_min = val.range.min; p->wall_density_max = val.range.max;
     }
+    if (config_read(cfg, "wall_mode", &val) && val.type == value_type::STRING) {
+        for (u8 m = 0; m < (u8)wall_mode::COUNT; m++) {
+            if (strcmp(val.str.arr, wall_mode_names[m]) == 0) p->walls = (wall_mode)m;
+        }
+    }
+    if (config_read(cfg, "wall_carve_straight", &val)) p->carve_straight = val.integer;
+}
+
+static void gen_scatter_walls(level *lvl, i32 num_walls) {
+    for (i32 w = 0; w < num_walls; w++) {
+        i32 x = rand_int_min(1, lvl->width - 1);
+        i32 y = rand_int_min(1, lvl->height - 1);
+        level_set_solid(lvl, {x, y}, true);
+    }
+}
+
+// Walls off every open region except the largest, so all elements share one space
+static void gen_seal_pockets(level *lvl) {
+    i32 region[MAP_MAX_SIZE];
+    i32 region_size[MAP_MAX_SIZE];
+    i32 num_regions = 0;
+    memset(region, -1, sizeof(region));
+
+    i32 queue[MAP_MAX_SIZE];
+    for (i32 y = 1; y < lvl->height - 1; y++) {
+        for (i32 x = 1; x < lvl->width - 1; x++) {
+            i32 idx = y * lvl->width + x;
+            if (region[idx] >= 0 || level_is_solid(lvl, {x, y})) continue;
+
+            i32 r = num_regions++;
+            i32 head = 0, tail = 0;
+            region[idx] = r;
+            queue[tail++] = idx;
+            while (head < tail) {
+                i32 cur = queue[head++];
+                ivec2 p = { cur % lvl->width, cur / lvl->width };
+                for (i32 d = 0; d < 4; d++) {
+                    ivec2 n = p + direction_vectors[d];
+                    i32 nidx = n.y * lvl->width + n.x;
+                    if (region[nidx] >= 0 || level_is_solid(lvl, n)) continue;
+                    region[nidx] = r;
+                    queue[tail++] = nidx;
+                }
+            }
+            region_size[r] = tail;
+        }
+    }
+
+    i32 largest = 0;
+    for (i32 r = 1; r < num_regions; r++) {
+        if (region_size[r] > region_size[largest]) largest = r;
+    }
+    for (i32 y = 1; y < lvl->height - 1; y++) {
+        for (i32 x = 1; x < lvl->width - 1; x++) {
+            i32 r = region[y * lvl->width + x];
+            if (r >= 0 && r != largest) level_set_solid(lvl, {x, y}, true);
+        }
+    }
+}
+
+// Fills the interior and walks a carver through it until enough cells are open. The
+// open space is connected by construction, and the straight bias leaves long runs for
+// elements to slide along instead of a maze of single-cell steps.
+static void gen_carve_walls(level *lvl, i32 num_walls, i32 straight) {
+    i32 interior_cells = (lvl->width - 2) * (lvl->height - 2);
+    for (i32 y = 1; y < lvl->height - 1; y++) {
+        for (i32 x = 1; x < lvl->width - 1; x++) {
+            level_set_solid(lvl, {x, y}, true);
+        }
+    }
+
+    i32 target_open = interior_cells - num_walls;
+    ivec2 p = { rand_int_min(1, lvl->width - 1), rand_int_min(1, lvl->height - 1) };
+    level_set_solid(lvl, p, false);
+    i32 num_open = 1;
+    i32 dir = rand_int(4);
+
+    // Bounded so a degenerate config cannot spin forever
+    for (i32 step = 0; num_open < target_open && step < interior_cells * 64; step++) {
+        if (rand_int(100) >= straight) dir = rand_int(4);
+
+        ivec2 n = p + direction_vectors[dir];
+        if (n.x < 1 || n.y < 1 || n.x >= lvl->width - 1 || n.y >= lvl->height - 1) {
+            dir = rand_int(4);
+            continue;
+        }
+        p = n;
+        if (level_is_solid(lvl, p)) {
+            level_set_solid(lvl, p, false);
+            num_open++;
+        }
+    }
 }
 
 bool gen_random_level(level *lvl, gen_params *p) {
@@ -60,10 +166,17 @@ bool gen_random_level(level *lvl, gen_params *p) {
     i32 density = rand_int_min(p->wall_density_min, p->wall_density_max + 1);
     i32 num_walls = (interior_cells * density) / 100;
 
-    for (i32 w = 0; w < num_walls; w++) {
-        i32 x = rand_int_min(1, lvl->width - 1);
-        i32 y = rand_int_min(1, lvl->height - 1);
-        level_set_solid(lvl, {x, y}, true);
+    switch (p->walls) {
+        case wall_mode::SEALED:
+            gen_scatter_walls(lvl, num_walls);
+            gen_seal_pockets(lvl);
+            break;
+        case wall_mode::CARVE:
+            gen_carve_walls(lvl, num_walls, p->carve_straight);
+            break;
+        default:
+            gen_scatter_walls(lvl, num_walls);
+            break;
     }
 
     // Collect open cells for element placement
@@ -94,6 +207,16 @@ bool gen_random_level(level *lvl, gen_params *p) {
         lvl->gem_colors[i] = (color)(i % num_colors);
     }
 
+    // Place crates
+    for (i32 i = 0; i < lvl->num_crates; i++) {
+        lvl->crate_starts[i] = open[lvl->num_gems + i];
+    }
+
+    return true;
+}
+
+// Cheap rejection checks run on a generated candidate before it reaches the solver
+bool gen_filter_level(level *lvl) {
     // Reject if any same-color gems are adjacent in starting state
     for (i32 i = 0; i < lvl->num_gems; i++) {
         for (i32 j = i + 1; j < lvl->num_gems; j++) {
@@ -104,10 +227,14 @@ bool gen_random_level(level *lvl, gen_params *p) {
         }
     }
 
-    // Place crates
-    for (i32 i = 0; i < lvl->num_crates; i++) {
-        lvl->crate_starts[i] = open[lvl->num_gems + i];
-    }
+    // A color with a single gem, or a gem boxed in by walls and immovable crates, can never match
+    sim_state start;
+    sim_init(&start, lvl);
+    if (sim_is_dead_end(&start)) return false;
+
+    level_analysis analysis;
+    level_analyze(lvl, &analysis);
+    if (analysis.stranded_gem) return false;
 
     return true;
 }
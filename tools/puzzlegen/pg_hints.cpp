@@ -0,0 +1,183 @@
+#include <vector>
+
+// Perfect-play oracle: distance-to-solution for every reachable state of a level,
+// stored as an open-addressed hash -> distance table next to the bundle (.hint).
+//
+// File layout (little endian):
+//   u32 magic ('G85H')
+//   u16 version
+//   u16 num_levels
+//   per level:
+//     u32 capacity          power of two, 0 = no table for this level
+//     u32 num_entries
+//     u32 keys[capacity]    high half of sim_state_hash, 0 = empty slot
+//     u8  dists[capacity]   moves to solution
+//
+// Slots are probed linearly from the low half of the hash. Only states that can still
+// reach a solution are stored, so a miss means "reset". The game hashes its attempt
+// state the same way as sim_state_hash, so keep both in sync. States are hashed on the
+// reduced level (see pg_reduce.cpp), which leaves fixed crates out.
+
+#define HINT_FILE_MAGIC 0x48353847u // "G85H"
+#define HINT_FILE_VERSION 2
+#define HINT_DEAD 0xFF
+#define HINT_MAX_DIST 0xFE
+#define HINT_DEFAULT_MAX_STATES 200000
+
+struct hint_table {
+    u32 capacity;
+    u32 num_entries;
+    u32 *keys;
+    u8 *dists;
+};
+
+static inline u32 hint_key(u64 hash) {
+    u32 key = (u32)(hash >> 32);
+    return key == 0 ? 1 : key; // 0 marks empty slots
+}
+
+static void hint_table_insert(hint_table *t, u64 hash, u8 dist) {
+    u32 key = hint_key(hash);
+    u32 mask = t->capacity - 1;
+    u32 slot = (u32)hash & mask;
+    while (t->keys[slot] != 0 && t->keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    if (t->keys[slot] == 0) t->num_entries++;
+    t->keys[slot] = key;
+    t->dists[slot] = dist;
+}
+
+void hint_table_free(hint_table *t) {
+    free(t->keys);
+    free(t->dists);
+    memset(t, 0, sizeof(hint_table));
+}
+
+// Explores the whole reachable state graph, then walks it backwards from every solved state.
+// Returns false (and an empty table) if the level has more than max_states reachable states.
+bool hint_table_build(level *lvl, i32 max_states, hint_table *out) {
+    memset(out, 0, sizeof(hint_table));
+
+    level reduced;
+    level_reduce(lvl, &reduced);
+    lvl = &reduced;
+
+    std::vector<sim_state> states;
+    std::vector<i32> succ;                  // 4 per state, -1 for the skipped gravity direction
+    std::unordered_map<u64, i32> index;
+    std::vector<u64> hashes;
+
+    sim_state start;
+    sim_init(&start, lvl);
+    states.push_back(start);
+    hashes.push_back(sim_state_hash(&start));
+    index[hashes[0]] = 0;
+
+    // Forward pass: plain BFS without early exit, recording edges
+    for (size_t i = 0; i < states.size(); i++) {
+        sim_state cur = states[i];
+        for (i32 d = 0; d < 4; d++) {
+            if ((direction)d == cur.current_gravity || sim_is_solved(&cur)) {
+                succ.push_back(-1);
+                continue;
+            }
+
+            sim_state next = cur;
+            sim_apply_move(&next, lvl, (direction)d);
+            u64 hash = sim_state_hash(&next);
+
+            auto it = index.find(hash);
+            if (it != index.end()) {
+                succ.push_back(it->second);
+                continue;
+            }
+            if ((i32)states.size() >= max_states) return false;
+
+            i32 id = (i32)states.size();
+            index[hash] = id;
+            states.push_back(next);
+            hashes.push_back(hash);
+            succ.push_back(id);
+        }
+    }
+
+    // Reverse adjacency in CSR form
+    i32 num_states = (i32)states.size();
+    std::vector<i32> rev_start(num_states + 1, 0);
+    for (i32 s : succ) {
+        if (s >= 0) rev_start[s + 1]++;
+    }
+    for (i32 i = 0; i < num_states; i++) rev_start[i + 1] += rev_start[i];
+
+    std::vector<i32> rev(rev_start[num_states]);
+    std::vector<i32> fill(rev_start.begin(), rev_start.end() - 1);
+    for (i32 i = 0; i < num_states; i++) {
+        for (i32 d = 0; d < 4; d++) {
+            i32 s = succ[i * 4 + d];
+            if (s >= 0) rev[fill[s]++] = i;
+        }
+    }
+
+    // Reverse pass: multi-source BFS from every solved state
+    std::vector<u8> dist(num_states, HINT_DEAD);
+    std::vector<i32> queue;
+    queue.reserve(num_states);
+    for (i32 i = 0; i < num_states; i++) {
+        if (sim_is_solved(&states[i])) {
+            dist[i] = 0;
+            queue.push_back(i);
+        }
+    }
+    for (size_t q = 0; q < queue.size(); q++) {
+        i32 cur = queue[q];
+        u8 next_dist = dist[cur] < HINT_MAX_DIST ? dist[cur] + 1 : HINT_MAX_DIST;
+        for (i32 r = rev_start[cur]; r < rev_start[cur + 1]; r++) {
+            i32 prev = rev[r];
+            if (dist[prev] != HINT_DEAD) continue;
+            dist[prev] = next_dist;
+            queue.push_back(prev);
+        }
+    }
+
+    i32 num_solvable = (i32)queue.size();
+
+    // Load factor <= 0.5 keeps probes short for the game's lookups
+    u32 capacity = 16;
+    while (capacity < (u32)num_solvable * 2) capacity <<= 1;
+
+    out->capacity = capacity;
+    out->keys = (u32 *)calloc(capacity, sizeof(u32));
+    out->dists = (u8 *)calloc(capacity, sizeof(u8));
+    for (i32 i = 0; i < num_states; i++) {
+        if (dist[i] != HINT_DEAD) hint_table_insert(out, hashes[i], dist[i]);
+    }
+    return true;
+}
+
+bool hint_file_write(hint_table *tables, i32 num_levels, const char *path) {
+    FILE *f;
+    i32 err = fopen_s(&f, path, "wb");
+    if (err != 0 || !f) return false;
+
+    u32 magic = HINT_FILE_MAGIC;
+    u16 version = HINT_FILE_VERSION;
+    u16 count = (u16)num_levels;
+    fwrite(&magic, sizeof(magic), 1, f);
+    fwrite(&version, sizeof(version), 1, f);
+    fwrite(&count, sizeof(count), 1, f);
+
+    for (i32 i = 0; i < num_levels; i++) {
+        hint_table *t = &tables[i];
+        fwrite(&t->capacity, sizeof(u32), 1, f);
+        fwrite(&t->num_entries, sizeof(u32), 1, f);
+        if (t->capacity > 0) {
+            fwrite(t->keys, sizeof(u32), t->capacity, f);
+            fwrite(t->dists, sizeof(u8), t->capacity, f);
+        }
+    }
+
+    bool ok = ferror(f) == 0;
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,147 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Persistent work-stealing pool for independent jobs indexed 0..count-1.
+// jobs_run splits the index space into one contiguous range per worker; a worker
+// pops from the front of its own range and, once empty, steals the back half of
+// another worker's range. Ranges are a packed (begin, end) pair updated with CAS,
+// so neither popping nor stealing takes a lock. The mutex is only used to start a
+// run and to wait for its end.
+
+#define JOBS_MAX_WORKERS 64
+
+typedef void (*job_fn)(void *user, i32 worker, i32 index);
+
+struct alignas(64) job_range {
+    std::atomic<u64> packed;    // begin in the low 32 bits, end in the high 32 bits
+};
+
+struct job_pool {
+    i32 num_workers;
+    std::thread threads[JOBS_MAX_WORKERS];
+    job_range ranges[JOBS_MAX_WORKERS];
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    u64 run_id;             // Bumped for every jobs_run, workers wait for a change
+    i32 busy;               // Workers still inside the current run
+    bool quit;
+
+    job_fn fn;
+    void *user;
+};
+
+static inline u64 job_range_pack(u32 begin, u32 end) {
+    return ((u64)end << 32) | begin;
+}
+
+// Front of the worker's own range, -1 if empty
+static i32 jobs_pop(job_range *r) {
+    u64 v = r->packed.load(std::memory_order_acquire);
+    for (;;) {
+        u32 begin = (u32)v;
+        u32 end = (u32)(v >> 32);
+        if (begin >= end) return -1;
+        if (r->packed.compare_exchange_weak(v, job_range_pack(begin + 1, end), std::memory_order_acq_rel)) {
+            return (i32)begin;
+        }
+    }
+}
+
+// Moves the back half of some other range into the worker's own. False once every range is empty.
+static bool jobs_steal(job_pool *pool, i32 worker) {
+    for (;;) {
+        bool saw_work = false;
+        for (i32 k = 1; k < pool->num_workers; k++) {
+            job_range *victim = &pool->ranges[(worker + k) % pool->num_workers];
+            u64 v = victim->packed.load(std::memory_order_acquire);
+            u32 begin = (u32)v;
+            u32 end = (u32)(v >> 32);
+            if (begin >= end) continue;
+            saw_work = true;
+
+            u32 take = (end - begin + 1) / 2;
+            if (victim->packed.compare_exchange_strong(v, job_range_pack(begin, end - take), std::memory_order_acq_rel)) {
+                pool->ranges[worker].packed.store(job_range_pack(end - take, end), std::memory_order_release);
+                return true;
+            }
+        }
+        // Ranges only ever shrink, so a full pass over empty ranges means the run is drained
+        if (!saw_work) return false;
+    }
+}
+
+static void jobs_worker(job_pool *pool, i32 worker) {
+    u64 seen_run = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [&] { return pool->quit || pool->run_id != seen_run; });
+            if (pool->quit) return;
+            seen_run = pool->run_id;
+        }
+
+        do {
+            i32 index;
+            while ((index = jobs_pop(&pool->ranges[worker])) >= 0) {
+                pool->fn(pool->user, worker, index);
+            }
+        } while (jobs_steal(pool, worker));
+
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (--pool->busy == 0) pool->done.notify_one();
+    }
+}
+
+// num_workers <= 0 means one per hardware thread
+void jobs_init(job_pool *pool, i32 num_workers) {
+    if (num_workers <= 0) num_workers = (i32)std::thread::hardware_concurrency();
+    if (num_workers < 1) num_workers = 1;
+    if (num_workers > JOBS_MAX_WORKERS) num_workers = JOBS_MAX_WORKERS;
+
+    pool->num_workers = num_workers;
+    pool->run_id = 0;
+    pool->busy = 0;
+    pool->quit = false;
+    for (i32 w = 0; w < num_workers; w++) {
+        pool->ranges[w].packed.store(0);
+        pool->threads[w] = std::thread(jobs_worker, pool, w);
+    }
+}
+
+// Runs fn(user, worker, i) for every i in [0, count) and returns once all are done
+void jobs_run(job_pool *pool, i32 count, job_fn fn, void *user) {
+    if (count <= 0) return;
+
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->fn = fn;
+    pool->user = user;
+
+    // Contiguous blocks keep neighbouring jobs on one worker until stealing kicks in
+    i32 n = pool->num_workers;
+    for (i32 w = 0; w < n; w++) {
+        u32 begin = (u32)((i64)count * w / n);
+        u32 end = (u32)((i64)count * (w + 1) / n);
+        pool->ranges[w].packed.store(job_range_pack(begin, end), std::memory_order_relaxed);
+    }
+
+    pool->busy = n;
+    pool->run_id++;
+    pool->wake.notify_all();
+    pool->done.wait(lock, [&] { return pool->busy == 0; });
+}
+
+void jobs_shutdown(job_pool *pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->quit = true;
+    }
+    pool->wake.notify_all();
+    for (i32 w = 0; w < pool->num_workers; w++) {
+        pool->threads[w].join();
+    }
+    pool->num_workers = 0;
+}
@@ -0,0 +1,137 @@
+#include <emmintrin.h>
+
+// Bulk decoder for contiguous 108-byte level records into structure-of-arrays columns.
+// Passes over big corpora usually look at a handful of fields (dims, counts, colors),
+// so each field gets its own array and a pass only streams the columns it reads.
+//
+// Per-element columns hold ELEMENTS_MAX_NUM slots per level. Slots past num_crates /
+// num_gems hold whatever the record has there, which is zero for anything written by
+// level_write_binary. Nibble positions and 2-bit colors are unpacked 16 lanes at a
+// time with SSE2.
+
+struct level_columns {
+    mem_arena arena;
+    i32 count;
+    i32 capacity;
+
+    u8 *width;
+    u8 *height;
+    u8 *start_gravity;
+    u8 *num_crates;
+    u8 *num_gems;
+
+    u8 *crate_x;        // count * ELEMENTS_MAX_NUM
+    u8 *crate_y;
+    u8 *gem_x;
+    u8 *gem_y;
+    u8 *gem_colors;
+
+    u8 *solid;          // count * LEVEL_COLUMNS_SOLID_BYTES, same bit layout as level::solid
+};
+
+#define LEVEL_COLUMNS_SOLID_BYTES (MAP_MAX_SIZE / 8)
+
+void level_columns_init(level_columns *cols, i32 capacity) {
+    u64 n = (u64)capacity;
+    u64 per_level = 5 + 5 * ELEMENTS_MAX_NUM + LEVEL_COLUMNS_SOLID_BYTES;
+    mem_arena_init(&cols->arena, n * per_level + 11 * 64);
+
+    cols->count = 0;
+    cols->capacity = capacity;
+    cols->width = mem_arena_alloc(&cols->arena, n, 64).p;
+    cols->height = mem_arena_alloc(&cols->arena, n, 64).p;
+    cols->start_gravity = mem_arena_alloc(&cols->arena, n, 64).p;
+    cols->num_crates = mem_arena_alloc(&cols->arena, n, 64).p;
+    cols->num_gems = mem_arena_alloc(&cols->arena, n, 64).p;
+    cols->crate_x = mem_arena_alloc(&cols->arena, n * ELEMENTS_MAX_NUM, 64).p;
+    cols->crate_y = mem_arena_alloc(&cols->arena, n * ELEMENTS_MAX_NUM, 64).p;
+    cols->gem_x = mem_arena_alloc(&cols->arena, n * ELEMENTS_MAX_NUM, 64).p;
+    cols->gem_y = mem_arena_alloc(&cols->arena, n * ELEMENTS_MAX_NUM, 64).p;
+    cols->gem_colors = mem_arena_alloc(&cols->arena, n * ELEMENTS_MAX_NUM, 64).p;
+    cols->solid = mem_arena_alloc(&cols->arena, n * LEVEL_COLUMNS_SOLID_BYTES, 64).p;
+}
+
+void level_columns_free(level_columns *cols) {
+    mem_arena_clear(&cols->arena);
+    cols->count = 0;
+    cols->capacity = 0;
+}
+
+// 32 packed (x << 4 | y) bytes into separate x and y arrays
+static inline void columns_unpack_positions(const u8 *src, u8 *xs, u8 *ys) {
+    const __m128i low = _mm_set1_epi8(0x0F);
+    for (i32 i = 0; i < ELEMENTS_MAX_NUM; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        // No 8-bit shift in SSE2: shift 16-bit lanes and mask off what crossed from the neighbour byte
+        __m128i x = _mm_and_si128(_mm_srli_epi16(v, 4), low);
+        __m128i y = _mm_and_si128(v, low);
+        _mm_storeu_si128((__m128i *)(xs + i), x);
+        _mm_storeu_si128((__m128i *)(ys + i), y);
+    }
+}
+
+// 64 bits of 2-bit colors into 32 bytes. Each source byte is spread over 4 lanes, then
+// every lane tests the two bits that belong to it.
+static inline void columns_unpack_colors(const u8 *src, u8 *out) {
+    const __m128i bit0 = _mm_set1_epi32(0x40100401);   // 1, 4, 16, 64 per group of 4 lanes
+    const __m128i bit1 = _mm_set1_epi32((i32)0x80200802);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi8(2);
+
+    __m128i packed = _mm_loadl_epi64((const __m128i *)src);
+    __m128i pairs = _mm_unpacklo_epi8(packed, packed);     // b0 b0 b1 b1 ... b7 b7
+    __m128i spread[2] = {
+        _mm_unpacklo_epi16(pairs, pairs),                   // b0 x4 .. b3 x4
+        _mm_unpackhi_epi16(pairs, pairs),                   // b4 x4 .. b7 x4
+    };
+    for (i32 h = 0; h < 2; h++) {
+        __m128i lo = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(spread[h], bit0), bit0), one);
+        __m128i hi = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(spread[h], bit1), bit1), two);
+        _mm_storeu_si128((__m128i *)(out + h * 16), _mm_or_si128(lo, hi));
+    }
+}
+
+// Appends count records from data (count * LEVEL_FILE_SIZE bytes). Returns how many fit.
+i32 level_columns_decode(level_columns *cols, const u8 *data, i32 count) {
+    if (count > cols->capacity - cols->count) count = cols->capacity - cols->count;
+
+    for (i32 i = 0; i < count; i++) {
+        const u8 *rec = data + (u64)i * LEVEL_FILE_SIZE;
+        u64 row = (u64)(cols->count + i);
+        u64 slots = row * ELEMENTS_MAX_NUM;
+
+        cols->width[row] = rec[0] >> 4;
+        cols->height[row] = rec[0] & 0x0F;
+        cols->start_gravity[row] = rec[1];
+        cols->num_crates[row] = rec[2];
+        cols->num_gems[row] = rec[3];
+
+        columns_unpack_colors(rec + 4, cols->gem_colors + slots);
+        columns_unpack_positions(rec + 12, cols->crate_x + slots, cols->crate_y + slots);
+        columns_unpack_positions(rec + 44, cols->gem_x + slots, cols->gem_y + slots);
+
+        u8 *solid = cols->solid + row * LEVEL_COLUMNS_SOLID_BYTES;
+        _mm_storeu_si128((__m128i *)solid, _mm_loadu_si128((const __m128i *)(rec + 76)));
+        _mm_storeu_si128((__m128i *)(solid + 16), _mm_loadu_si128((const __m128i *)(rec + 92)));
+    }
+    cols->count += count;
+    return count;
+}
+
+// Row i as a level, same result as level_read_binary on the record it came from
+void level_columns_get(level_columns *cols, i32 i, level *lvl) {
+    u64 slots = (u64)i * ELEMENTS_MAX_NUM;
+    lvl->width = (i8)cols->width[i];
+    lvl->height = (i8)cols->height[i];
+    lvl->start_gravity = (direction)cols->start_gravity[i];
+    lvl->num_crates = (i8)cols->num_crates[i];
+    lvl->num_gems = (i8)cols->num_gems[i];
+    for (i32 c = 0; c < lvl->num_crates; c++) {
+        lvl->crate_starts[c] = { cols->crate_x[slots + c], cols->crate_y[slots + c] };
+    }
+    for (i32 g = 0; g < lvl->num_gems; g++) {
+        lvl->gem_starts[g] = { cols->gem_x[slots + g], cols->gem_y[slots + g] };
+        lvl->gem_colors[g] = (color)cols->gem_colors[slots + g];
+    }
+    memcpy(lvl->solid, cols->solid + (u64)i * LEVEL_COLUMNS_SOLID_BYTES, LEVEL_COLUMNS_SOLID_BYTES);
+}
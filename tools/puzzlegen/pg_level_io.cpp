@@ -40,10 +40,6 @@ inline void level_set_solid(level *lvl, ivec2 pos, bool solid) {
     else       lvl->solid[idx / 8] &= ~(1 << (idx % 8));
 }
 
-inline ivec2 unpack_pos(u8 packed) {
-    return { packed >> 4, packed & 0xF };
-}
-
 inline u8 pack_pos(ivec2 pos) {
     return (u8)((pos.x << 4) | (pos.y & 0xF));
 }
@@ -133,19 +129,45 @@ struct bundle {
     i32 optimal_moves[5];
 };
 
+#ifdef _WIN32
+// From <windows.h>, declared here to keep its macros out of the unity build
+extern "C" __declspec(dllimport) int __stdcall MoveFileExA(const char *existing, const char *replacement, unsigned long flags);
+#define WIN_MOVEFILE_REPLACE_EXISTING 0x1
+#define WIN_MOVEFILE_WRITE_THROUGH 0x8
+#endif
+
+// Moves tmp_path over path in one step: path is always either the old file or the new one,
+// and stays the old one if the move fails. rename() refuses to replace on Windows.
+bool file_replace(const char *tmp_path, const char *path) {
+#ifdef _WIN32
+    return MoveFileExA(tmp_path, path, WIN_MOVEFILE_REPLACE_EXISTING | WIN_MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(tmp_path, path) == 0;
+#endif
+}
+
+// Both files are written under a .tmp name and renamed once complete
 bool bundle_write(bundle *b, const char *bin_path, const char *meta_path) {
+    char tmp_path[260];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", bin_path);
+
     FILE *f;
-    i32 err = fopen_s(&f, bin_path, "wb");
+    i32 err = fopen_s(&f, tmp_path, "wb");
     if (err != 0 || !f) return false;
 
+    u8 data[5 * LEVEL_FILE_SIZE];
     for (i32 i = 0; i < 5; i++) {
-        u8 data[LEVEL_FILE_SIZE];
-        level_write_binary(&b->levels[i], data);
-        fwrite(data, LEVEL_FILE_SIZE, 1, f);
+        level_write_binary(&b->levels[i], data + i * LEVEL_FILE_SIZE);
+    }
+    bool ok = fwrite(data, sizeof(data), 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || !file_replace(tmp_path, bin_path)) {
+        remove(tmp_path);
+        return false;
     }
-    fclose(f);
 
-    err = fopen_s(&f, meta_path, "w");
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", meta_path);
+    err = fopen_s(&f, tmp_path, "w");
     if (err != 0 || !f) return false;
 
     fprintf(f, "# Bundle metadata\n");
@@ -153,6 +175,10 @@ bool bundle_write(bundle *b, const char *bin_path, const char *meta_path) {
         fprintf(f, "level_%d: difficulty=%.4f optimal_moves=%d\n",
                 i, b->difficulty_scores[i], b->optimal_moves[i]);
     }
-    fclose(f);
+    ok = fclose(f) == 0;
+    if (!ok || !file_replace(tmp_path, meta_path)) {
+        remove(tmp_path);
+        return false;
+    }
     return true;
 }
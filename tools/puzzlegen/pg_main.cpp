@@ -8,11 +8,19 @@
 #include "qg_config.hpp"
 #include "qg_random.hpp"
 
+#define PUZZLEGEN_VERSION "0.2"
+
 struct cli_args {
     const char *config_path;
     const char *output_dir;
     const char *tier_name;
+    const char *report_path;
     i32 num_puzzles;
+    i32 bench_levels;
+    i32 bench_novelty;
+    i32 bench_archive;
+    i32 bench_columns;
+    i32 bench_writer;
     i64 seed;
     bool verbose;
 };
@@ -21,7 +29,13 @@ void cli_parse(cli_args *args, int argc, char **argv) {
     args->config_path = "puzzlegen.cfg";
     args->output_dir = nullptr;
     args->tier_name = nullptr;
+    args->report_path = nullptr;
     args->num_puzzles = 0;
+    args->bench_levels = 0;
+    args->bench_novelty = 0;
+    args->bench_archive = 0;
+    args->bench_columns = 0;
+    args->bench_writer = 0;
     args->seed = 0;
     args->verbose = false;
 
@@ -36,6 +50,18 @@ void cli_parse(cli_args *args, int argc, char **argv) {
             args->seed = atoll(argv[++i]);
         } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
             args->output_dir = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            args->report_path = argv[++i];
+        } else if (strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+            args->bench_levels = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-N") == 0 && i + 1 < argc) {
+            args->bench_novelty = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-A") == 0 && i + 1 < argc) {
+            args->bench_archive = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+            args->bench_columns = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-W") == 0 && i + 1 < argc) {
+            args->bench_writer = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-v") == 0) {
             args->verbose = true;
         } else {
@@ -45,12 +71,20 @@ void cli_parse(cli_args *args, int argc, char **argv) {
             printf("  -t <tier>    Bundle tier: easy|medium|hard|expert\n");
             printf("  -s <seed>    RNG seed (0 = random)\n");
             printf("  -o <dir>     Output directory\n");
+            printf("  -r <path>    Telemetry report (.json or .csv)\n");
+            printf("  -B <count>   Benchmark scalar vs bitboard solver on <count> levels and exit\n");
+            printf("  -N <count>   Benchmark the novelty index up to <count> levels and exit\n");
+            printf("  -A <count>   Benchmark the corpus archive on <count> levels and exit\n");
+            printf("  -D <count>   Benchmark bulk column decoding on <count> levels and exit\n");
+            printf("  -W <count>   Benchmark per-file vs packed bundle output on <count> bundles and exit\n");
             printf("  -v           Verbose output\n");
         }
     }
 }
 
 int main(int argc, char **argv) {
+    stats_time run_start = stats_now();
+
     cli_args args;
     cli_parse(&args, argc, argv);
 
@@ -83,6 +117,11 @@ int main(int argc, char **argv) {
             args.tier_name = val.str.arr;
         }
     }
+    if (!args.report_path) {
+        if (config_read(&cfg, "report_path", &val) && val.type == value_type::STRING) {
+            args.report_path = val.str.arr;
+        }
+    }
 
     i32 max_attempts = 1000;
     if (config_read(&cfg, "max_attempts", &val)) max_attempts = val.integer;
@@ -93,6 +132,94 @@ int main(int argc, char **argv) {
     i32 max_visited = SOLVER_DEFAULT_MAX_STATES;
     if (config_read(&cfg, "max_visited_states", &val)) max_visited = val.integer;
 
+    if (args.bench_levels > 0) {
+        bench_expand_run(&cfg, args.seed, args.bench_levels, max_solve_moves);
+        config_free(&cfg);
+        return 0;
+    }
+    if (args.bench_novelty > 0) {
+        bench_novelty_run(&cfg, args.seed, args.bench_novelty);
+        config_free(&cfg);
+        return 0;
+    }
+    if (args.bench_archive > 0) {
+        bench_archive_run(&cfg, args.seed, args.bench_archive, args.output_dir);
+        config_free(&cfg);
+        return 0;
+    }
+    if (args.bench_columns > 0) {
+        bench_columns_run(&cfg, args.seed, args.bench_columns);
+        config_free(&cfg);
+        return 0;
+    }
+    if (args.bench_writer > 0) {
+        bench_writer_run(&cfg, args.seed, args.bench_writer, args.output_dir);
+        config_free(&cfg);
+        return 0;
+    }
+
+    // "external" spills BFS layers to disk for state spaces that don't fit in memory,
+    // "bitboard" expands successors with SSE2 board masks
+    bool external_solver = false;
+    bool bitboard_solver = false;
+    if (config_read(&cfg, "solver_mode", &val) && val.type == value_type::STRING) {
+        external_solver = strcmp(val.str.arr, "external") == 0;
+        bitboard_solver = strcmp(val.str.arr, "bitboard") == 0;
+    }
+
+    ext_params ep;
+    ep.spill_dir = "spill";
+    ep.mem_budget = EXT_DEFAULT_MEM_BUDGET;
+    if (config_read(&cfg, "solver_spill_dir", &val) && val.type == value_type::STRING) {
+        ep.spill_dir = val.str.arr;
+    }
+    if (config_read(&cfg, "solver_mem_budget_mb", &val) && val.integer > 0) {
+        ep.mem_budget = (u64)val.integer * 1024 * 1024;
+    }
+
+    i64 ext_max_states = EXT_DEFAULT_MAX_STATES;
+    if (config_read(&cfg, "solver_external_max_states", &val) && val.integer > 0) {
+        ext_max_states = val.integer;
+    }
+
+    // Per-candidate solver budget, 0 = unlimited
+    solve_budget budget = {};
+    if (config_read(&cfg, "solve_time_limit_ms", &val) && val.integer > 0) {
+        budget.max_seconds = val.integer / 1000.0;
+    }
+    if (config_read(&cfg, "solve_memory_limit_mb", &val) && val.integer > 0) {
+        budget.max_bytes = (u64)val.integer * 1024 * 1024;
+    }
+
+    // Candidates are generated in batches and solved across a job pool
+    i32 solve_batch_size = 64;
+    if (config_read(&cfg, "solve_batch_size", &val) && val.integer > 0) solve_batch_size = val.integer;
+
+    i32 solver_threads = 0;
+    if (config_read(&cfg, "solver_threads", &val)) solver_threads = val.integer;
+
+    bool use_tier_window = true;
+    if (config_read(&cfg, "solve_tier_window", &val)) use_tier_window = val.integer != 0;
+
+    bool write_hints = false;
+    if (config_read(&cfg, "hints", &val)) write_hints = val.integer != 0;
+
+    // "files" writes a .bin/.txt pair per bundle, "pack" appends every bundle to one
+    // bundles_<tier>.bin/.txt pair through the background writer
+    bool pack_output = false;
+    if (config_read(&cfg, "bundle_output", &val) && val.type == value_type::STRING) {
+        pack_output = strcmp(val.str.arr, "pack") == 0;
+    }
+
+    u64 writer_buffer = WRITER_DEFAULT_BUFFER_SIZE;
+    if (config_read(&cfg, "writer_buffer_kb", &val) && val.integer > 0) writer_buffer = (u64)val.integer * 1024;
+
+    bool write_corpus = false;
+    if (config_read(&cfg, "corpus_archive", &val)) write_corpus = val.integer != 0;
+
+    i32 hint_max_states = HINT_DEFAULT_MAX_STATES;
+    if (config_read(&cfg, "hint_max_states", &val)) hint_max_states = val.integer;
+
     printf("puzzlegen: seed=%lld puzzles=%d tier=%s output=%s\n",
            args.seed, args.num_puzzles, args.tier_name, args.output_dir);
 
@@ -105,40 +232,163 @@ int main(int argc, char **argv) {
     // Load difficulty weights
     difficulty_weights dw;
     difficulty_weights_from_config(&dw, &cfg);
+    bool use_graph_stats = difficulty_weights_use_graph(&dw);
+    if (external_solver && use_graph_stats) {
+        printf("WARNING: state-graph weights are ignored with solver_mode = \"external\"\n");
+        use_graph_stats = false;
+    }
+    if (bitboard_solver && use_graph_stats) {
+        printf("WARNING: state-graph weights are ignored with solver_mode = \"bitboard\"\n");
+        use_graph_stats = false;
+    }
+
+    // Near-duplicates of accepted puzzles are dropped before the expensive scoring stages
+    novelty_params np;
+    novelty_params_from_config(&np, &cfg);
+    novelty_index *novelty = new novelty_index();
+    novelty_init(novelty, &np);
+
+    playout_params pp;
+    playout_params_from_config(&pp, &cfg, max_solve_moves);
+    pp.seed = args.seed;
+    bool use_playouts = dw.playout > 0.0f;
 
     // Load bundle tier
     bundle_tier tier;
     bundle_tier_from_config(&tier, &cfg, args.tier_name);
 
+    // Candidates whose optimal length cannot land in the tier are abandoned mid-search
+    if (use_tier_window) {
+        bundle_tier_move_window(&tier, &dw, max_solve_moves, &budget.min_moves, &budget.max_moves);
+        printf("Tier move window: [%d, %d]\n", budget.min_moves, budget.max_moves);
+        if (budget.min_moves > budget.max_moves) {
+            printf("WARNING: empty move window for tier %s, no candidate can be accepted\n", args.tier_name);
+        }
+    }
+
+    pg_stats stats;
+    stats_init(&stats, max_solve_moves);
+
     // Generate puzzle pool
     puzzle_entry *pool = (puzzle_entry *)malloc(sizeof(puzzle_entry) * args.num_puzzles);
     i32 pool_count = 0;
     i32 attempts = 0;
 
-    while (pool_count < args.num_puzzles && attempts < max_attempts) {
-        attempts++;
-
-        level lvl;
-        if (!gen_random_level(&lvl, &gp)) continue;
-
-        solve_result sol = solver_solve(&lvl, max_solve_moves, max_visited);
-        if (!sol.solvable) continue;
+    level *batch = (level *)malloc(sizeof(level) * solve_batch_size);
+    solve_result *batch_results = (solve_result *)malloc(sizeof(solve_result) * solve_batch_size);
+    solver_graph_stats *batch_graphs = use_graph_stats
+        ? (solver_graph_stats *)malloc(sizeof(solver_graph_stats) * solve_batch_size)
+        : nullptr;
 
-        f32 diff = difficulty_score(&lvl, &sol, &dw, max_solve_moves);
+    solver_params sp;
+    sp.max_depth = max_solve_moves;
+    sp.max_states = max_visited;
+    sp.num_threads = solver_threads;
+    sp.budget = &budget;
+    sp.graph_stats = batch_graphs;
+    sp.bitboard = bitboard_solver;
 
-        pool[pool_count].lvl = lvl;
-        pool[pool_count].sol = sol;
-        pool[pool_count].difficulty = diff;
-        pool_count++;
+    while (pool_count < args.num_puzzles && attempts < max_attempts) {
+        // Generation stays sequential so the RNG sequence only depends on the seed
+        i32 batch_count = 0;
+        while (batch_count < solve_batch_size && attempts < max_attempts) {
+            attempts++;
+            stats.candidates++;
+
+            level lvl;
+            stats_time t = stats_now();
+            bool generated = gen_random_level(&lvl, &gp);
+            stats_stage_add(&stats, pg_stage::GENERATE, t);
+            if (!generated) { stats.rejected_generate++; continue; }
+
+            t = stats_now();
+            bool passed = gen_filter_level(&lvl);
+            stats_stage_add(&stats, pg_stage::FILTER, t);
+            if (!passed) { stats.rejected_filter++; continue; }
+
+            batch[batch_count++] = lvl;
+        }
 
-        if (args.verbose) {
-            printf("  [%d/%d] solvable in %d moves, difficulty=%.4f (explored %d states)\n",
-                   pool_count, args.num_puzzles, sol.optimal_moves, diff, sol.states_explored);
+        stats_time t = stats_now();
+        if (external_solver) {
+            for (i32 i = 0; i < batch_count; i++) {
+                batch_results[i] = solver_solve_external(&batch[i], max_solve_moves, ext_max_states, &ep, &budget);
+            }
+        } else {
+            solver_solve_batch(batch, batch_count, &sp, batch_results);
+        }
+        stats_stage_add(&stats, pg_stage::SOLVE, t);
+
+        for (i32 i = 0; i < batch_count && pool_count < args.num_puzzles; i++) {
+            level &lvl = batch[i];
+            solve_result &sol = batch_results[i];
+            solver_graph_stats *graph = use_graph_stats ? &batch_graphs[i] : nullptr;
+
+            stats_record_solve(&stats, &sol);
+            if (sol.stop == solve_stop::TOO_SHORT || sol.stop == solve_stop::TOO_LONG) {
+                stats.rejected_window++;
+                continue;
+            }
+            if (!sol.solvable) {
+                stats.rejected_unsolved++;
+                if (args.verbose && (sol.stop == solve_stop::TIME_LIMIT || sol.stop == solve_stop::MEMORY_LIMIT)) {
+                    printf("  gave up after %.3fs (%s), optimal >= %d moves\n",
+                           sol.seconds, solve_stop_names[(u8)sol.stop], sol.lower_bound);
+                }
+                continue;
+            }
+
+            f32 features[NOVELTY_DIMS];
+            novelty_features(&lvl, &sol, features);
+            if (!novelty_accept(novelty, features)) {
+                stats.rejected_similar++;
+                continue;
+            }
+
+            t = stats_now();
+            playout_result playout = {};
+            if (use_playouts) playout = playout_estimate(&lvl, &pp);
+            f32 diff = difficulty_score(&lvl, &sol, &dw, max_solve_moves, graph, use_playouts ? &playout : nullptr);
+            stats_stage_add(&stats, pg_stage::SCORE, t);
+            stats_hist_add(&stats.difficulty, diff);
+            stats.accepted++;
+
+            pool[pool_count].lvl = lvl;
+            pool[pool_count].sol = sol;
+            pool[pool_count].difficulty = diff;
+            memcpy(pool[pool_count].features, features, sizeof(features));
+            pool_count++;
+
+            if (args.verbose) {
+                printf("  [%d/%d] solvable in %d moves, difficulty=%.4f (explored %d states)\n",
+                       pool_count, args.num_puzzles, sol.optimal_moves, diff, sol.states_explored);
+                if (graph) {
+                    printf("          branching=%.2f dead_ends=%.2f optimal_solutions=%llu\n",
+                           graph->branching_factor, graph->dead_end_ratio, graph->optimal_solutions);
+                }
+                if (use_playouts) {
+                    printf("          playouts: success=%.3f expected_resets=%.2f\n",
+                           playout.success_rate, playout.expected_resets);
+                }
+            }
         }
     }
 
+    solver_batch_shutdown();
+    playout_shutdown();
+    free(batch);
+    free(batch_results);
+    free(batch_graphs);
+
     printf("Generated %d/%d solvable puzzles in %d attempts\n",
            pool_count, args.num_puzzles, attempts);
+    if (np.min_distance > 0.0f) {
+        printf("Novelty: %d near-duplicates rejected, %.1f candidates checked per query\n",
+               stats.rejected_similar,
+               novelty->queries ? (f64)novelty->candidates_checked / novelty->queries : 0.0);
+    }
+    novelty_free(novelty);
+    delete novelty;
 
     if (pool_count < 5) {
         printf("ERROR: Not enough puzzles for a bundle (need at least 5, got %d)\n", pool_count);
@@ -148,20 +398,57 @@ int main(int argc, char **argv) {
     }
 
     // Sort and assemble bundles
+    stats_time assemble_start = stats_now();
     pool_sort_by_difficulty(pool, pool_count);
 
     // Create output directory
     _mkdir(args.output_dir);
 
+    // Whole accepted pool, for later analysis or re-assembly without regenerating
+    if (write_corpus) {
+        char corpus_path[256];
+        snprintf(corpus_path, sizeof(corpus_path), "%s/corpus_%s.pga", args.output_dir, args.tier_name);
+        level *corpus = (level *)malloc(sizeof(level) * pool_count);
+        for (i32 i = 0; i < pool_count; i++) corpus[i] = pool[i].lvl;
+        if (archive_write(corpus, pool_count, corpus_path)) {
+            printf("Wrote corpus: %s (%d levels)\n", corpus_path, pool_count);
+        } else {
+            printf("ERROR: Could not write corpus: %s\n", corpus_path);
+        }
+        free(corpus);
+    }
+
     // Assemble as many bundles as we can
     i32 bundles_made = 0;
     i32 pool_offset = 0;
 
+    batch_writer *pack_bin = nullptr;
+    batch_writer *pack_meta = nullptr;
+    char pack_path[256], pack_meta_path[256];
+    if (pack_output) {
+        snprintf(pack_path, sizeof(pack_path), "%s/bundles_%s.bin", args.output_dir, args.tier_name);
+        snprintf(pack_meta_path, sizeof(pack_meta_path), "%s/bundles_%s.txt", args.output_dir, args.tier_name);
+        pack_bin = new batch_writer();
+        pack_meta = new batch_writer();
+        bool bin_open = batch_writer_open(pack_bin, pack_path, writer_buffer);
+        bool meta_open = batch_writer_open(pack_meta, pack_meta_path, writer_buffer);
+        if (bin_open && meta_open) {
+            batch_writer_printf(pack_meta, "# Bundle metadata\n");
+        } else {
+            printf("ERROR: Could not open bundle pack: %s\n", pack_path);
+            if (bin_open) { pack_bin->failed = true; batch_writer_close(pack_bin); }
+            if (meta_open) { pack_meta->failed = true; batch_writer_close(pack_meta); }
+            delete pack_bin;
+            delete pack_meta;
+            pack_bin = pack_meta = nullptr;
+        }
+    }
+
     // Find tier range in sorted pool
     while (true) {
         bundle b = {};
         // Try to assemble from remaining pool
-        if (!bundle_assemble(&b, pool + pool_offset, pool_count - pool_offset, &tier)) {
+        if (!bundle_assemble(&b, pool + pool_offset, pool_count - pool_offset, &tier, np.min_distance)) {
             break;
         }
 
@@ -171,9 +458,35 @@ int main(int argc, char **argv) {
         snprintf(meta_path, sizeof(meta_path), "%s/bundle_%s_%03d.txt",
                  args.output_dir, args.tier_name, bundles_made);
 
-        if (bundle_write(&b, bin_path, meta_path)) {
-            printf("Wrote bundle: %s (difficulties: %.2f -> %.2f)\n",
-                   bin_path, b.difficulty_scores[0], b.difficulty_scores[4]);
+        bool written;
+        if (pack_output) {
+            written = pack_bin != nullptr;
+            if (written) bundle_pack_append(pack_bin, pack_meta, &b, bundles_made);
+        } else {
+            written = bundle_write(&b, bin_path, meta_path);
+            if (written) {
+                printf("Wrote bundle: %s (difficulties: %.2f -> %.2f)\n",
+                       bin_path, b.difficulty_scores[0], b.difficulty_scores[4]);
+            }
+        }
+
+        if (written) {
+            if (write_hints) {
+                char hint_path[256];
+                snprintf(hint_path, sizeof(hint_path), "%s/bundle_%s_%03d.hint",
+                         args.output_dir, args.tier_name, bundles_made);
+
+                hint_table tables[5];
+                for (i32 i = 0; i < 5; i++) {
+                    if (!hint_table_build(&b.levels[i], hint_max_states, &tables[i])) {
+                        printf("  level %d: too many states for a hint table\n", i);
+                    }
+                }
+                if (!hint_file_write(tables, 5, hint_path)) {
+                    printf("ERROR: Could not write hints: %s\n", hint_path);
+                }
+                for (i32 i = 0; i < 5; i++) hint_table_free(&tables[i]);
+            }
             bundles_made++;
         }
 
@@ -182,8 +495,33 @@ int main(int argc, char **argv) {
         if (pool_offset + 5 > pool_count) break;
     }
 
+    if (pack_bin) {
+        bool bin_ok = batch_writer_close(pack_bin);
+        bool meta_ok = batch_writer_close(pack_meta);
+        if (bin_ok && meta_ok) {
+            printf("Wrote bundle pack: %s (%d bundles)\n", pack_path, bundles_made);
+        } else {
+            printf("ERROR: Could not write bundle pack: %s\n", pack_path);
+            bundles_made = 0;
+        }
+        delete pack_bin;
+        delete pack_meta;
+    }
+
+    stats_stage_add(&stats, pg_stage::ASSEMBLE, assemble_start);
+    stats.bundles_written = bundles_made;
+
     printf("Summary: %d bundles written to %s/\n", bundles_made, args.output_dir);
 
+    stats.total_seconds = stats_seconds_since(run_start);
+    if (args.report_path) {
+        if (stats_write_report(&stats, args.report_path, PUZZLEGEN_VERSION, args.seed, args.tier_name)) {
+            printf("Wrote report: %s\n", args.report_path);
+        } else {
+            printf("ERROR: Could not write report: %s\n", args.report_path);
+        }
+    }
+
     free(pool);
     config_free(&cfg);
     return 0;
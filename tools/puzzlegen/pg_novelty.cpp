@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <cfloat>
+#include <random>
+
+// Near-duplicate detection. Every level maps to a short feature vector (a coarse
+// wall sketch, where its gems sit and in which colors, and the shape of its optimal
+// solution); two levels closer than min_distance in that space feel like the same
+// puzzle. Lookups go through a Euclidean LSH index: L tables, each keyed by K
+// quantized random projections, so a query only measures the few entries sharing a
+// bucket with it instead of the whole corpus.
+
+#define NOVELTY_DIMS 32
+#define NOVELTY_MAX_TABLES 16
+#define NOVELTY_MAX_PROJECTIONS 16
+#define NOVELTY_PROJECTION_SEED 0x9E3779B97F4A7C15ull
+
+// Bucket width relative to min_distance; wider buckets find more true neighbours per table
+#define NOVELTY_BUCKET_SCALE 4.0f
+
+struct novelty_params {
+    f32 min_distance;   // 0 = disabled
+    i32 num_tables;     // L
+    i32 num_projections;// K
+};
+
+// Open-addressed bucket heads; entries of a bucket are chained through `next`
+struct novelty_table {
+    std::vector<u64> keys;  // 0 = empty
+    std::vector<u32> heads;
+    std::vector<u32> next;  // Per entry, UINT32_MAX ends the chain
+    u32 num_buckets;
+};
+
+struct novelty_index {
+    novelty_params params;
+    f32 bucket_width;
+    f32 proj[NOVELTY_MAX_TABLES][NOVELTY_MAX_PROJECTIONS][NOVELTY_DIMS];
+    f32 offset[NOVELTY_MAX_TABLES][NOVELTY_MAX_PROJECTIONS];
+    novelty_table tables[NOVELTY_MAX_TABLES];
+
+    std::vector<f32> vectors;   // count * NOVELTY_DIMS
+    std::vector<u32> stamps;    // Last query that measured each entry, so shared candidates are measured once
+    u32 query_id;
+    u32 count;
+
+    u64 candidates_checked;     // Summed over all queries
+    u64 queries;
+};
+
+void novelty_params_from_config(novelty_params *p, config *cfg) {
+    config_value val;
+    p->min_distance = 0.0f;
+    p->num_tables = 10;
+    p->num_projections = 8;
+
+    if (config_read(cfg, "novelty_min_distance", &val) && val.type == value_type::FLOAT) p->min_distance = val.flt;
+    if (config_read(cfg, "novelty_tables", &val)) p->num_tables = val.integer;
+    if (config_read(cfg, "novelty_projections", &val)) p->num_projections = val.integer;
+
+    if (p->num_tables < 1) p->num_tables = 1;
+    if (p->num_tables > NOVELTY_MAX_TABLES) p->num_tables = NOVELTY_MAX_TABLES;
+    if (p->num_projections < 1) p->num_projections = 1;
+    if (p->num_projections > NOVELTY_MAX_PROJECTIONS) p->num_projections = NOVELTY_MAX_PROJECTIONS;
+}
+
+// sol may be null (no solution shape yet); those dimensions stay zero
+void novelty_features(level *lvl, solve_result *sol, f32 out[NOVELTY_DIMS]) {
+    memset(out, 0, sizeof(f32) * NOVELTY_DIMS);
+    i32 iw = lvl->width - 2;
+    i32 ih = lvl->height - 2;
+
+    // [0, 16): wall fraction of each cell of a 4x4 grid over the interior
+    f32 cells[16] = {};
+    for (i32 y = 1; y < lvl->height - 1; y++) {
+        for (i32 x = 1; x < lvl->width - 1; x++) {
+            i32 b = ((y - 1) * 4 / ih) * 4 + (x - 1) * 4 / iw;
+            cells[b] += 1.0f;
+            if (level_is_solid(lvl, { x, y })) out[b] += 1.0f;
+        }
+    }
+    for (i32 b = 0; b < 16; b++) {
+        if (cells[b] > 0.0f) out[b] /= cells[b];
+    }
+
+    // [16, 20): gems per interior quadrant, [20, 23): color counts largest first
+    f32 inv_gems = lvl->num_gems > 0 ? 1.0f / lvl->num_gems : 0.0f;
+    i32 color_counts[3] = {};
+    for (i32 i = 0; i < lvl->num_gems; i++) {
+        ivec2 p = lvl->gem_starts[i];
+        i32 q = ((p.y - 1) * 2 / ih) * 2 + (p.x - 1) * 2 / iw;
+        out[16 + q] += inv_gems;
+        color_counts[(i32)lvl->gem_colors[i]]++;
+    }
+    std::sort(color_counts, color_counts + 3, [](i32 a, i32 b) { return a > b; });
+    for (i32 c = 0; c < 3; c++) out[20 + c] = color_counts[c] * inv_gems;
+
+    i32 elements = lvl->num_gems + lvl->num_crates;
+    out[23] = elements > 0 ? (f32)lvl->num_crates / elements : 0.0f;
+
+    // [24, 29): share of each direction in the optimal solution, and its length
+    if (sol && sol->solvable && sol->optimal_moves > 0) {
+        for (i32 m = 0; m < sol->optimal_moves; m++) {
+            out[24 + (i32)sol->solution[m]] += 1.0f / sol->optimal_moves;
+        }
+        out[28] = (f32)sol->optimal_moves / SOLVER_MAX_MOVES;
+    }
+
+    // [29, 32): size and element count
+    out[29] = lvl->width / 16.0f;
+    out[30] = lvl->height / 16.0f;
+    out[31] = (f32)lvl->num_gems / ELEMENTS_MAX_NUM;
+}
+
+f32 novelty_distance(const f32 *a, const f32 *b) {
+    f32 sum = 0.0f;
+    for (i32 i = 0; i < NOVELTY_DIMS; i++) {
+        f32 d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sqrtf(sum);
+}
+
+void novelty_init(novelty_index *idx, novelty_params *p) {
+    idx->params = *p;
+    idx->bucket_width = p->min_distance > 0.0f ? p->min_distance * NOVELTY_BUCKET_SCALE : 1.0f;
+    idx->query_id = 0;
+    idx->count = 0;
+    idx->candidates_checked = 0;
+    idx->queries = 0;
+
+    // Fixed seed: projections must not depend on (or disturb) the generation RNG
+    std::mt19937_64 eng(NOVELTY_PROJECTION_SEED);
+    std::normal_distribution<f32> normal(0.0f, 1.0f);
+    std::uniform_real_distribution<f32> uniform(0.0f, idx->bucket_width);
+    for (i32 t = 0; t < p->num_tables; t++) {
+        for (i32 k = 0; k < p->num_projections; k++) {
+            for (i32 d = 0; d < NOVELTY_DIMS; d++) idx->proj[t][k][d] = normal(eng);
+            idx->offset[t][k] = uniform(eng);
+        }
+        novelty_table *tab = &idx->tables[t];
+        tab->keys.assign(1024, 0);
+        tab->heads.assign(1024, 0);
+        tab->next.clear();
+        tab->num_buckets = 0;
+    }
+}
+
+void novelty_free(novelty_index *idx) {
+    for (i32 t = 0; t < NOVELTY_MAX_TABLES; t++) {
+        idx->tables[t] = novelty_table();
+    }
+    idx->vectors = std::vector<f32>();
+    idx->stamps = std::vector<u32>();
+    idx->count = 0;
+}
+
+static u64 novelty_key(novelty_index *idx, i32 t, const f32 *v) {
+    u64 h = 14695981039346656037ull;
+    for (i32 k = 0; k < idx->params.num_projections; k++) {
+        f32 dot = idx->offset[t][k];
+        for (i32 d = 0; d < NOVELTY_DIMS; d++) dot += idx->proj[t][k][d] * v[d];
+        i64 cell = (i64)floorf(dot / idx->bucket_width);
+        for (i32 b = 0; b < 8; b++) {
+            h ^= (u8)(cell >> (b * 8));
+            h *= 1099511628211ull;
+        }
+    }
+    return h == 0 ? 1 : h;
+}
+
+// Slot holding key, or the empty slot where it would go
+static u32 novelty_slot(novelty_table *tab, u64 key) {
+    u32 mask = (u32)tab->keys.size() - 1;
+    u32 slot = (u32)key & mask;
+    while (tab->keys[slot] != 0 && tab->keys[slot] != key) slot = (slot + 1) & mask;
+    return slot;
+}
+
+static void novelty_grow(novelty_table *tab) {
+    std::vector<u64> old_keys;
+    std::vector<u32> old_heads;
+    old_keys.swap(tab->keys);
+    old_heads.swap(tab->heads);
+    tab->keys.assign(old_keys.size() * 2, 0);
+    tab->heads.assign(old_keys.size() * 2, 0);
+    for (size_t i = 0; i < old_keys.size(); i++) {
+        if (old_keys[i] == 0) continue;
+        u32 slot = novelty_slot(tab, old_keys[i]);
+        tab->keys[slot] = old_keys[i];
+        tab->heads[slot] = old_heads[i];
+    }
+}
+
+// Distance to the nearest indexed entry sharing a bucket with v, FLT_MAX if none does.
+// Approximate: a true neighbour is missed only if every table splits the pair.
+f32 novelty_nearest(novelty_index *idx, const f32 *v) {
+    f32 best = FLT_MAX;
+    idx->query_id++;
+    idx->queries++;
+    for (i32 t = 0; t < idx->params.num_tables; t++) {
+        novelty_table *tab = &idx->tables[t];
+        u32 slot = novelty_slot(tab, novelty_key(idx, t, v));
+        if (tab->keys[slot] == 0) continue;
+
+        for (u32 e = tab->heads[slot]; e != UINT32_MAX; e = tab->next[e]) {
+            if (idx->stamps[e] == idx->query_id) continue;
+            idx->stamps[e] = idx->query_id;
+            idx->candidates_checked++;
+
+            f32 d = novelty_distance(v, &idx->vectors[(size_t)e * NOVELTY_DIMS]);
+            if (d < best) best = d;
+        }
+    }
+    return best;
+}
+
+void novelty_insert(novelty_index *idx, const f32 *v) {
+    u32 e = idx->count++;
+    idx->vectors.insert(idx->vectors.end(), v, v + NOVELTY_DIMS);
+    idx->stamps.push_back(0);
+
+    for (i32 t = 0; t < idx->params.num_tables; t++) {
+        novelty_table *tab = &idx->tables[t];
+        if ((tab->num_buckets + 1) * 2 > tab->keys.size()) novelty_grow(tab);
+
+        u64 key = novelty_key(idx, t, v);
+        u32 slot = novelty_slot(tab, key);
+        if (tab->keys[slot] == 0) {
+            tab->keys[slot] = key;
+            tab->heads[slot] = UINT32_MAX;
+            tab->num_buckets++;
+        }
+        tab->next.push_back(tab->heads[slot]);
+        tab->heads[slot] = e;
+    }
+}
+
+// Inserts v unless something indexed lies within min_distance. True if inserted.
+bool novelty_accept(novelty_index *idx, const f32 *v) {
+    if (idx->params.min_distance <= 0.0f) return true;
+    if (novelty_nearest(idx, v) < idx->params.min_distance) return false;
+    novelty_insert(idx, v);
+    return true;
+}
@@ -0,0 +1,195 @@
+// Monte Carlo difficulty estimate: how often does a (semi-)random player
+// clear the level within N moves. Playouts are split into fixed batches
+// that are stepped in lockstep, and batches are jobs on a job_pool that
+// persists across levels until playout_shutdown.
+
+#define PLAYOUT_BATCH 64
+
+struct playout_params {
+    i32 num_playouts;   // Total playouts per level
+    i32 max_moves;      // A playout that is not solved after this many moves counts as a reset
+    f32 greedy_bias;    // 0 = uniform random moves, 1 = always take the move clearing the most gems
+    i32 num_threads;    // 0 = one per hardware thread
+    i64 seed;
+};
+
+struct playout_result {
+    i32 playouts;
+    i32 successes;
+    f32 success_rate;
+    f32 mean_moves_to_solve;    // Over successful playouts only
+    f32 expected_resets;        // Geometric expectation (1 - p) / p, capped at playouts
+};
+
+void playout_params_from_config(playout_params *p, config *cfg, i32 max_solve_moves) {
+    config_value val;
+
+    p->num_playouts = 2000;
+    p->max_moves = max_solve_moves * 2;
+    p->greedy_bias = 0.5f;
+    p->num_threads = 0;
+    p->seed = 0;
+
+    if (config_read(cfg, "playout_count", &val)) p->num_playouts = val.integer;
+    if (config_read(cfg, "playout_max_moves", &val) && val.integer > 0) p->max_moves = val.integer;
+    if (config_read(cfg, "playout_greedy_bias", &val) && val.type == value_type::FLOAT) p->greedy_bias = val.flt;
+    if (config_read(cfg, "playout_threads", &val)) p->num_threads = val.integer;
+}
+
+static i32 playout_active_gems(sim_state *s) {
+    u32 v = s->gems_active;
+    i32 n = 0;
+    while (v) { v &= v - 1; n++; }
+    return n;
+}
+
+static direction playout_pick_move(level *lvl, sim_state *s, f32 greedy_bias) {
+    direction options[3];
+    i32 num_options = 0;
+    for (i32 d = 0; d < 4; d++) {
+        if ((direction)d != s->current_gravity) options[num_options++] = (direction)d;
+    }
+
+    if (greedy_bias <= 0.0f || rand_float01() >= greedy_bias) {
+        return options[rand_int(num_options)];
+    }
+
+    // Greedy: fewest gems left wins, random tie-break via the starting offset
+    i32 offset = rand_int(num_options);
+    direction best = options[offset];
+    i32 best_gems = ELEMENTS_MAX_NUM + 1;
+    for (i32 i = 0; i < num_options; i++) {
+        direction dir = options[(offset + i) % num_options];
+        sim_state next = *s;
+        sim_apply_move(&next, lvl, dir);
+        i32 gems = playout_active_gems(&next);
+        if (gems < best_gems) {
+            best_gems = gems;
+            best = dir;
+        }
+    }
+    return best;
+}
+
+struct playout_tally {
+    i32 playouts;
+    i32 successes;
+    i64 solve_moves;
+};
+
+// Runs one lockstep batch; lanes share a contiguous sim_state block so each step stays in cache
+static void playout_run_batch(level *lvl, playout_params *p, i32 batch_index, i32 lanes, playout_tally *tally) {
+    sim_state states[PLAYOUT_BATCH];
+    bool done[PLAYOUT_BATCH];
+
+    // Seeded per batch so the estimate does not depend on the thread count
+    rand_seed(p->seed ^ ((i64)batch_index * 0x9E3779B97F4A7C15ll));
+
+    sim_init(&states[0], lvl);
+    for (i32 i = 0; i < lanes; i++) {
+        states[i] = states[0];
+        done[i] = false;
+    }
+
+    i32 live = lanes;
+    for (i32 m = 1; m <= p->max_moves && live > 0; m++) {
+        for (i32 i = 0; i < lanes; i++) {
+            if (done[i]) continue;
+
+            direction dir = playout_pick_move(lvl, &states[i], p->greedy_bias);
+            sim_apply_move(&states[i], lvl, dir);
+
+            if (sim_is_solved(&states[i])) {
+                done[i] = true;
+                live--;
+                tally->successes++;
+                tally->solve_moves += m;
+            } else if (sim_is_dead_end(&states[i])) {
+                // Unwinnable from here on: the player has to reset
+                done[i] = true;
+                live--;
+            }
+        }
+    }
+    tally->playouts += lanes;
+}
+
+struct playout_job {
+    level *lvl;
+    playout_params *params;
+    playout_tally tallies[JOBS_MAX_WORKERS];    // One per worker, summed once the run is over
+};
+
+struct playout_pool {
+    job_pool pool;
+    i32 num_threads;    // As requested, so a different count restarts the pool
+};
+
+static playout_pool *g_playout_pool = nullptr;
+
+static void playout_batch_job(void *user, i32 worker, i32 index) {
+    playout_job *job = (playout_job *)user;
+    i32 lanes = job->params->num_playouts - index * PLAYOUT_BATCH;
+    if (lanes > PLAYOUT_BATCH) lanes = PLAYOUT_BATCH;
+
+    // Counted locally so workers don't share tally cache lines while stepping
+    playout_tally tally = {};
+    playout_run_batch(job->lvl, job->params, index, lanes, &tally);
+    job->tallies[worker].playouts += tally.playouts;
+    job->tallies[worker].successes += tally.successes;
+    job->tallies[worker].solve_moves += tally.solve_moves;
+}
+
+playout_result playout_estimate(level *lvl, playout_params *p) {
+    playout_result result = {};
+    if (p->num_playouts <= 0) return result;
+
+    playout_pool *pp = g_playout_pool;
+    if (pp && pp->num_threads != p->num_threads) {
+        jobs_shutdown(&pp->pool);
+    } else if (!pp) {
+        pp = g_playout_pool = new playout_pool();
+        pp->num_threads = -1;
+    }
+    if (pp->num_threads != p->num_threads) {
+        jobs_init(&pp->pool, p->num_threads);
+        pp->num_threads = p->num_threads;
+    }
+
+    // Fixed crates never move, so playouts run on the reduced level
+    level reduced;
+    level_reduce(lvl, &reduced);
+
+    // Always on the pool's workers: batches reseed the thread_local RNG, which must not
+    // disturb the caller's generation sequence
+    playout_job job = {};
+    job.lvl = &reduced;
+    job.params = p;
+    i32 num_batches = (p->num_playouts + PLAYOUT_BATCH - 1) / PLAYOUT_BATCH;
+    jobs_run(&pp->pool, num_batches, playout_batch_job, &job);
+
+    i64 solve_moves = 0;
+    for (i32 t = 0; t < pp->pool.num_workers; t++) {
+        result.playouts += job.tallies[t].playouts;
+        result.successes += job.tallies[t].successes;
+        solve_moves += job.tallies[t].solve_moves;
+    }
+
+    result.success_rate = (f32)result.successes / (f32)result.playouts;
+    result.mean_moves_to_solve = result.successes > 0 ? (f32)solve_moves / (f32)result.successes : 0.0f;
+    result.expected_resets = result.successes > 0
+        ? (1.0f - result.success_rate) / result.success_rate
+        : (f32)result.playouts;
+    if (result.expected_resets > (f32)result.playouts) result.expected_resets = (f32)result.playouts;
+
+    return result;
+}
+
+void playout_shutdown() {
+    playout_pool *pp = g_playout_pool;
+    if (!pp) return;
+
+    jobs_shutdown(&pp->pool);
+    delete pp;
+    g_playout_pool = nullptr;
+}
@@ -0,0 +1,124 @@
+// Per-level static analysis. Walls never move, so a crate blocked on all four sides
+// by walls or other such crates can never move either: gravity only ever pushes an
+// element into a free neighbouring cell. The fixed set is the greatest fixed point of
+// that rule. Fixed crates are folded into the solid map of a reduced copy, so the
+// search state, hashing and every gravity step only deal with crates that can move.
+//
+// The game runs the same reduction (level_fold_fixed_crates in gr_main.cpp) so hint
+// hashes keep matching. Keep both in sync.
+
+struct level_analysis {
+    u32 fixed_crates;       // Bit i set if crate_starts[i] can never move
+    i32 num_fixed_crates;
+    i32 unreachable_cells;  // Free cells outside every element's reach
+    bool stranded_gem;      // Some gem is walled in on all sides, so it can never match
+};
+
+static bool reduce_cell_solid(level *lvl, ivec2 p) {
+    if (p.x < 0 || p.y < 0 || p.x >= lvl->width || p.y >= lvl->height) return true;
+    return level_is_solid(lvl, p);
+}
+
+static i32 reduce_crate_at(level *lvl, ivec2 p) {
+    for (i32 i = 0; i < lvl->num_crates; i++) {
+        if (lvl->crate_starts[i] == p) return i;
+    }
+    return -1;
+}
+
+// Solid, or a crate still in the fixed set
+static bool reduce_blocked(level *lvl, u32 fixed, ivec2 p) {
+    if (reduce_cell_solid(lvl, p)) return true;
+    i32 c = reduce_crate_at(lvl, p);
+    return c >= 0 && ((fixed >> c) & 1);
+}
+
+// Elements only slide through free cells, so whatever no start can flood into stays empty forever
+static void reduce_reachable(level *lvl, u32 fixed, bool reached[MAP_MAX_SIZE]) {
+    memset(reached, 0, sizeof(bool) * MAP_MAX_SIZE);
+    i32 queue[MAP_MAX_SIZE];
+    i32 head = 0, tail = 0;
+    auto seed = [&](ivec2 p) {
+        i32 idx = p.y * lvl->width + p.x;
+        if (!reached[idx]) { reached[idx] = true; queue[tail++] = idx; }
+    };
+    for (i32 i = 0; i < lvl->num_crates; i++) {
+        if (!((fixed >> i) & 1)) seed(lvl->crate_starts[i]);
+    }
+    for (i32 i = 0; i < lvl->num_gems; i++) seed(lvl->gem_starts[i]);
+
+    while (head < tail) {
+        i32 idx = queue[head++];
+        ivec2 p = { idx % lvl->width, idx / lvl->width };
+        for (i32 d = 0; d < 4; d++) {
+            ivec2 n = p + direction_vectors[d];
+            if (!reduce_blocked(lvl, fixed, n)) seed(n);
+        }
+    }
+}
+
+void level_analyze(level *lvl, level_analysis *out) {
+    memset(out, 0, sizeof(level_analysis));
+
+    // Start from every crate and drop the ones with an escape until nothing changes
+    u32 fixed = lvl->num_crates >= 32 ? 0xFFFFFFFFu : (1u << lvl->num_crates) - 1;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (i32 i = 0; i < lvl->num_crates; i++) {
+            if (!((fixed >> i) & 1)) continue;
+            for (i32 d = 0; d < 4; d++) {
+                if (!reduce_blocked(lvl, fixed, lvl->crate_starts[i] + direction_vectors[d])) {
+                    fixed &= ~(1u << i);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    out->fixed_crates = fixed;
+    for (u32 v = fixed; v; v &= v - 1) out->num_fixed_crates++;
+
+    for (i32 i = 0; i < lvl->num_gems && !out->stranded_gem; i++) {
+        bool boxed = true;
+        for (i32 d = 0; d < 4 && boxed; d++) {
+            boxed = reduce_blocked(lvl, fixed, lvl->gem_starts[i] + direction_vectors[d]);
+        }
+        out->stranded_gem = boxed;
+    }
+
+    bool reached[MAP_MAX_SIZE];
+    reduce_reachable(lvl, fixed, reached);
+    for (i32 y = 0; y < lvl->height; y++) {
+        for (i32 x = 0; x < lvl->width; x++) {
+            ivec2 p = { x, y };
+            if (!reached[y * lvl->width + x] && !reduce_blocked(lvl, fixed, p)) out->unreachable_cells++;
+        }
+    }
+}
+
+// Copy of lvl with fixed crates and unreachable cells turned into walls and the fixed
+// crates dropped from crate_starts. Gem indices are unchanged, so solutions carry over.
+void level_reduce(level *lvl, level *out, level_analysis *analysis = nullptr) {
+    level_analysis local;
+    if (!analysis) analysis = &local;
+    level_analyze(lvl, analysis);
+
+    *out = *lvl;
+    if (analysis->num_fixed_crates == 0 && analysis->unreachable_cells == 0) return;
+
+    u32 fixed = analysis->fixed_crates;
+    bool reached[MAP_MAX_SIZE];
+    reduce_reachable(lvl, fixed, reached);
+    for (i32 y = 0; y < lvl->height; y++) {
+        for (i32 x = 0; x < lvl->width; x++) {
+            if (!reached[y * lvl->width + x]) level_set_solid(out, { x, y }, true);
+        }
+    }
+
+    out->num_crates = 0;
+    memset(out->crate_starts, 0, sizeof(out->crate_starts));
+    for (i32 i = 0; i < lvl->num_crates; i++) {
+        if (!((fixed >> i) & 1)) out->crate_starts[out->num_crates++] = lvl->crate_starts[i];
+    }
+}
@@ -142,3 +142,12 @@ void sim_apply_move(sim_state *s, level *lvl, direction dir) {
 bool sim_is_solved(sim_state *s) {
     return s->gems_active == 0;
 }
+
+// A color with a single active gem left can never be matched again
+bool sim_is_dead_end(sim_state *s) {
+    i32 color_counts[3] = {};
+    for (i32 i = 0; i < s->num_gems; i++) {
+        if ((s->gems_active >> i) & 1) color_counts[(i32)s->gem_colors[i]]++;
+    }
+    return color_counts[0] == 1 || color_counts[1] == 1 || color_counts[2] == 1;
+}
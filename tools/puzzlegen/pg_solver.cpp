@@ -1,19 +1,71 @@
+#include <unordered_map>
 #include <unordered_set>
 #include <queue>
+#include <chrono>
 
 #define SOLVER_MAX_MOVES 64
 #define SOLVER_DEFAULT_DEPTH 15
 #define SOLVER_DEFAULT_MAX_STATES 2000000
 
+#define SOLVER_BUDGET_CHECK_INTERVAL 1024
+
+// Why the search stopped. Everything but SOLVED and TOO_SHORT leaves solvable = false.
+enum class solve_stop : u8 {
+    SOLVED,         // Shortest solution found
+    EXHAUSTED,      // Every reachable state visited, no solution exists
+    DEPTH_LIMIT,    // Hit max_depth, a longer solution may exist
+    STATE_LIMIT,    // Hit max_states
+    TIME_LIMIT,     // Hit solve_budget::max_seconds
+    MEMORY_LIMIT,   // Hit solve_budget::max_bytes
+    TOO_SHORT,      // Solved, but in fewer than solve_budget::min_moves
+    TOO_LONG,       // No solution within solve_budget::max_moves
+    IO_ERROR,       // External solver could not open, read or write its spill files
+    COUNT
+};
+
+static const char *solve_stop_names[(u8)solve_stop::COUNT] = {
+    "solved", "exhausted", "depth_limit", "state_limit", "time_limit",
+    "memory_limit", "too_short", "too_long", "io_error",
+};
+
+// Optional limits on top of max_depth / max_states. Zero means unlimited.
+// The move window lets the caller give up on candidates it would reject anyway.
+struct solve_budget {
+    f64 max_seconds;
+    u64 max_bytes;      // Compared against the peak_bytes estimate
+    i32 min_moves;
+    i32 max_moves;
+};
+
 struct solve_result {
     bool solvable;
     i32 optimal_moves;
     i32 states_explored;
+    u64 peak_bytes;     // Estimated high-water mark of visited set + frontier
+    solve_stop stop;
+    i32 lower_bound;    // No solution is shorter than this (equals optimal_moves when solved)
+    f64 seconds;
     direction solution[SOLVER_MAX_MOVES];
 };
 
+// Optional state-graph metrics collected during the same BFS pass.
+// When requested, the solver finishes the layer holding the first solution
+// so every shortest move sequence is counted.
+struct solver_graph_stats {
+    i32 states_per_depth[SOLVER_MAX_MOVES + 1]; // Newly visited states per BFS layer
+    i32 deepest_layer;
+    i32 expanded;           // Nodes whose successors were generated
+    i32 successors;         // Successor moves that changed the board (pure gravity flips excluded)
+    i32 visited;
+    i32 dead_ends;          // Visited states that can never be solved
+    u64 optimal_solutions;  // Distinct shortest move sequences
+    f32 branching_factor;   // successors / expanded
+    f32 dead_end_ratio;     // dead_ends / visited
+};
+
 struct solver_node {
     sim_state state;
+    u64 hash;
     i32 depth;
     direction moves[SOLVER_MAX_MOVES];
 };
@@ -84,37 +136,167 @@ static u64 sim_state_hash(sim_state *s) {
     return h;
 }
 
-solve_result solver_solve(level *lvl, i32 max_depth, i32 max_states) {
+// Approximate heap footprint of the search containers (node-based set + deque of nodes)
+static u64 solver_memory_estimate(std::unordered_set<u64> &visited, std::queue<solver_node> &frontier) {
+    u64 set_bytes = visited.size() * (sizeof(u64) + 2 * sizeof(void *))
+                  + visited.bucket_count() * sizeof(void *);
+    u64 queue_bytes = frontier.size() * sizeof(solver_node);
+    return set_bytes + queue_bytes;
+}
+
+static bool sim_board_changed(sim_state *a, sim_state *b) {
+    if (a->gems_active != b->gems_active) return true;
+    if (memcmp(a->crates, b->crates, sizeof(ivec2) * a->num_crates) != 0) return true;
+    return memcmp(a->gems, b->gems, sizeof(ivec2) * a->num_gems) != 0;
+}
+
+static void solver_graph_stats_finish(solver_graph_stats *gs) {
+    gs->branching_factor = gs->expanded > 0 ? (f32)gs->successors / (f32)gs->expanded : 0.0f;
+    gs->dead_end_ratio = gs->visited > 0 ? (f32)gs->dead_ends / (f32)gs->visited : 0.0f;
+}
+
+typedef std::chrono::steady_clock::time_point solver_time;
+
+static inline solver_time solver_now() {
+    return std::chrono::steady_clock::now();
+}
+
+static inline f64 solver_seconds_since(solver_time start) {
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Clamps max_depth to the budget window; returns the stop reason to report if that cap is hit
+static solve_stop solver_depth_cap(i32 *max_depth, solve_budget *budget) {
+    if (*max_depth > SOLVER_MAX_MOVES) *max_depth = SOLVER_MAX_MOVES;
+    if (budget && budget->max_moves > 0 && budget->max_moves < *max_depth) {
+        *max_depth = budget->max_moves;
+        return solve_stop::TOO_LONG;
+    }
+    return solve_stop::DEPTH_LIMIT;
+}
+
+// Marks a found solution, flagging it when it falls below the budget window
+static void solver_mark_solved(solve_result *result, i32 moves, solve_budget *budget) {
+    result->solvable = true;
+    result->optimal_moves = moves;
+    result->lower_bound = moves;
+    result->stop = (budget && moves < budget->min_moves) ? solve_stop::TOO_SHORT : solve_stop::SOLVED;
+}
+
+// Wall-clock and memory checks, amortised over SOLVER_BUDGET_CHECK_INTERVAL expansions
+static bool solver_over_budget(solve_result *result, solve_budget *budget, solver_time start, i32 expanded) {
+    if (!budget) return false;
+    if (budget->max_bytes > 0 && result->peak_bytes > budget->max_bytes) {
+        result->stop = solve_stop::MEMORY_LIMIT;
+        return true;
+    }
+    if (budget->max_seconds > 0.0 && (expanded % SOLVER_BUDGET_CHECK_INTERVAL) == 0 &&
+        solver_seconds_since(start) > budget->max_seconds) {
+        result->stop = solve_stop::TIME_LIMIT;
+        return true;
+    }
+    return false;
+}
+
+// Searches run on the reduced level, where fixed crates are walls. Returns false (with
+// result filled in) when the static analysis alone proves the level unsolvable.
+static bool solver_prepare(level *lvl, level *reduced, solve_result *result) {
+    level_analysis analysis;
+    level_reduce(lvl, reduced, &analysis);
+    if (analysis.stranded_gem) {
+        result->stop = solve_stop::EXHAUSTED;
+        result->states_explored = 1;
+        result->lower_bound = 1;
+        return false;
+    }
+    return true;
+}
+
+solve_result solver_solve(level *lvl, i32 max_depth, i32 max_states, solver_graph_stats *gs = nullptr,
+                          solve_budget *budget = nullptr) {
     solve_result result = {};
+    if (gs) memset(gs, 0, sizeof(solver_graph_stats));
+    solver_time start_time = solver_now();
+    solve_stop depth_stop = solver_depth_cap(&max_depth, budget);
+
+    level reduced;
+    if (!solver_prepare(lvl, &reduced, &result)) return result;
+    lvl = &reduced;
 
     sim_state start;
     sim_init(&start, lvl);
 
     if (sim_is_solved(&start)) {
-        result.solvable = true;
-        result.optimal_moves = 0;
+        solver_mark_solved(&result, 0, budget);
         result.states_explored = 1;
+        result.peak_bytes = sizeof(sim_state);
+        if (gs) {
+            gs->states_per_depth[0] = 1;
+            gs->visited = 1;
+            gs->optimal_solutions = 1;
+        }
         return result;
     }
 
     std::unordered_set<u64> visited;
     std::queue<solver_node> frontier;
 
+    // Shortest-path counts for the layer being expanded and the one being discovered (stats only)
+    std::unordered_map<u64, u64> layer_paths, next_paths;
+    i32 layer_depth = 0;
+
     solver_node root = {};
     root.state = start;
+    root.hash = sim_state_hash(&root.state);
     root.depth = 0;
 
-    visited.insert(sim_state_hash(&root.state));
+    visited.insert(root.hash);
     frontier.push(root);
+    if (gs) {
+        gs->states_per_depth[0] = 1;
+        gs->visited = 1;
+        gs->dead_ends = sim_is_dead_end(&start) ? 1 : 0;
+        layer_paths[root.hash] = 1;
+    }
+
+    // Every layer shallower than the one being expanded is known to be solution-free
+    result.lower_bound = 1;
+    result.stop = solve_stop::EXHAUSTED;
+    bool depth_capped = false;
 
     while (!frontier.empty()) {
-        if ((i32)visited.size() >= max_states) break;
+        if ((i32)visited.size() >= max_states) {
+            if (!result.solvable) result.stop = solve_stop::STATE_LIMIT;
+            break;
+        }
+
+        u64 mem = solver_memory_estimate(visited, frontier);
+        if (mem > result.peak_bytes) result.peak_bytes = mem;
+        if (!result.solvable && solver_over_budget(&result, budget, start_time, result.states_explored)) break;
 
         solver_node node = frontier.front();
         frontier.pop();
+
+        // Once a solution is known, only the remainder of its parent layer is worth expanding
+        if (result.solvable && node.depth >= result.optimal_moves) break;
         result.states_explored++;
 
-        if (node.depth >= max_depth) continue;
+        if (!result.solvable && node.depth + 1 > result.lower_bound) result.lower_bound = node.depth + 1;
+        if (node.depth >= max_depth) {
+            depth_capped = true;
+            continue;
+        }
+
+        u64 node_paths = 0;
+        if (gs) {
+            if (node.depth != layer_depth) {
+                layer_paths.swap(next_paths);
+                next_paths.clear();
+                layer_depth = node.depth;
+            }
+            node_paths = layer_paths[node.hash];
+            gs->expanded++;
+        }
 
         for (i32 d = 0; d < 4; d++) {
             direction dir = (direction)d;
@@ -122,28 +304,59 @@ solve_result solver_solve(level *lvl, i32 max_depth, i32 max_states) {
 
             sim_state next = node.state;
             sim_apply_move(&next, lvl, dir);
+            bool solved = sim_is_solved(&next);
 
             u64 hash = sim_state_hash(&next);
+            if (gs) {
+                if (sim_board_changed(&node.state, &next)) gs->successors++;
+                if (solved) {
+                    gs->optimal_solutions += node_paths;
+                } else {
+                    // Duplicates within the next layer are extra shortest paths; older layers are not
+                    auto it = next_paths.find(hash);
+                    if (it != next_paths.end()) it->second += node_paths;
+                }
+            }
+
             if (visited.count(hash)) continue;
             visited.insert(hash);
 
             solver_node child = {};
             child.state = next;
+            child.hash = hash;
             child.depth = node.depth + 1;
             memcpy(child.moves, node.moves, sizeof(direction) * node.depth);
             child.moves[node.depth] = dir;
 
-            if (sim_is_solved(&next)) {
-                result.solvable = true;
-                result.optimal_moves = child.depth;
-                result.states_explored++;
-                memcpy(result.solution, child.moves, sizeof(direction) * child.depth);
-                return result;
+            if (gs) {
+                gs->visited++;
+                gs->states_per_depth[child.depth]++;
+                if (child.depth > gs->deepest_layer) gs->deepest_layer = child.depth;
+                if (!solved && sim_is_dead_end(&next)) gs->dead_ends++;
+                if (!solved) next_paths[hash] = node_paths;
             }
 
-            frontier.push(child);
+            if (solved) {
+                if (!result.solvable) {
+                    solver_mark_solved(&result, child.depth, budget);
+                    result.states_explored++;
+                    memcpy(result.solution, child.moves, sizeof(direction) * child.depth);
+                }
+                if (!gs) {
+                    result.seconds = solver_seconds_since(start_time);
+                    return result;
+                }
+                continue;
+            }
+
+            if (!result.solvable) frontier.push(child);
         }
     }
 
+    if (!result.solvable && result.stop == solve_stop::EXHAUSTED && depth_capped) {
+        result.stop = depth_stop;
+    }
+    result.seconds = solver_seconds_since(start_time);
+    if (gs) solver_graph_stats_finish(gs);
     return result;
 }
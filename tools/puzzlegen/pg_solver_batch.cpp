@@ -0,0 +1,271 @@
+// Batch solving: many independent levels spread over a job_pool. Each worker owns a
+// solver_context whose arena reserves address space once and is reset between levels,
+// so a batch allocates nothing per level. Pages are committed as a level reaches them
+// and whatever a large level committed past SOLVER_ARENA_KEEP is given back on reset.
+// Nodes are stored compactly (ext_pack record + parent index + move) in BFS order,
+// which doubles as the frontier queue.
+
+struct solver_params {
+    i32 max_depth;
+    i32 max_states;
+    i32 num_threads;                    // 0 = one per hardware thread
+    solve_budget *budget;               // Optional, applied to every level
+    solver_graph_stats *graph_stats;    // Optional, one per level; solved with solver_solve when set
+    bool bitboard;                      // Solve with solver_solve_bitboard, ignores graph_stats
+};
+
+struct solver_context {
+    mem_arena arena;
+    u64 *table;         // Open-addressed hashes of visited records, 0 = empty
+    u64 table_cap;
+    u32 table_mask;
+    u32 *slots;         // Table slot of every node, so the next level clears only what was used
+    u32 num_slots;
+    u8 *records;        // ext_pack records in BFS order
+    u32 *parents;
+    direction *moves;   // Move that led from the parent
+};
+
+struct solver_batch {
+    job_pool pool;
+    solver_context contexts[JOBS_MAX_WORKERS];
+    i32 num_threads;    // As requested, so a different count restarts the pool
+
+    // Current run
+    level *levels;
+    solve_result *results;
+    solver_params params;
+};
+
+#define SOLVER_ARENA_RESERVE (1ull << 32)          // Per worker, address space only
+#define SOLVER_ARENA_KEEP (32ull * 1024 * 1024)     // Committed bytes a worker holds on to between levels
+
+static solver_batch *g_solver_batch = nullptr;
+
+static u64 solver_record_hash(const u8 *rec, i32 size) {
+    u64 h = 14695981039346656037ull;
+    for (i32 i = 0; i < size; i++) {
+        h ^= rec[i];
+        h *= 1099511628211ull;
+    }
+    return h == 0 ? 1 : h;
+}
+
+// Table sized for the batch's max_states; the arena is only reserved again past SOLVER_ARENA_RESERVE
+static void solver_context_reserve(solver_context *ctx, i32 max_states, i32 record_size) {
+    u64 table_cap = 16;
+    while (table_cap < (u64)max_states * 2) table_cap <<= 1;
+
+    // Up to three successors can be added after the max_states check
+    u64 nodes = (u64)max_states + 4;
+    u64 size = table_cap * sizeof(u64)
+             + nodes * (record_size + 2 * sizeof(u32) + sizeof(direction))
+             + 5 * 64;
+    if (ctx->arena.base && ctx->arena.cap >= size && ctx->table_cap == table_cap) return;
+
+    if (!ctx->arena.base || ctx->arena.cap < size) {
+        if (ctx->arena.base) mem_arena_clear(&ctx->arena);
+        mem_arena_init_virtual(&ctx->arena, size > SOLVER_ARENA_RESERVE ? size : SOLVER_ARENA_RESERVE, SOLVER_ARENA_KEEP);
+    }
+
+    // The table always sits at the start of the arena and is cleared incrementally after this,
+    // table pages a reset decommits come back zeroed too
+    mem_arena_reset(&ctx->arena);
+    memset(mem_arena_alloc(&ctx->arena, table_cap * sizeof(u64), 64).p, 0, table_cap * sizeof(u64));
+    ctx->table_cap = table_cap;
+    ctx->num_slots = 0;
+}
+
+static void solver_context_begin(solver_context *ctx, i32 max_states, i32 record_size) {
+    u64 table_cap = ctx->table_cap;
+    u64 nodes = (u64)max_states + 4;
+
+    // Slots from the previous level, before the reset hands the memory out again
+    for (u32 i = 0; i < ctx->num_slots; i++) {
+        ctx->table[ctx->slots[i]] = 0;
+    }
+    ctx->num_slots = 0;
+
+    mem_arena_reset(&ctx->arena);
+    ctx->table = (u64 *)mem_arena_alloc(&ctx->arena, table_cap * sizeof(u64), 64).p;
+    ctx->table_mask = (u32)(table_cap - 1);
+    ctx->slots = (u32 *)mem_arena_alloc(&ctx->arena, nodes * sizeof(u32), 64).p;
+    ctx->records = mem_arena_alloc(&ctx->arena, nodes * record_size, 64).p;
+    ctx->parents = (u32 *)mem_arena_alloc(&ctx->arena, nodes * sizeof(u32), 64).p;
+    ctx->moves = (direction *)mem_arena_alloc(&ctx->arena, nodes * sizeof(direction), 64).p;
+}
+
+// True if newly inserted
+static bool solver_context_insert(solver_context *ctx, u64 hash) {
+    u32 slot = (u32)hash & ctx->table_mask;
+    while (ctx->table[slot] != 0) {
+        if (ctx->table[slot] == hash) return false;
+        slot = (slot + 1) & ctx->table_mask;
+    }
+    ctx->table[slot] = hash;
+    ctx->slots[ctx->num_slots++] = slot;
+    return true;
+}
+
+// Same search and result semantics as solver_solve without graph stats
+static solve_result solver_solve_context(solver_context *ctx, level *lvl, i32 max_depth, i32 max_states,
+                                         solve_budget *budget) {
+    solve_result result = {};
+    solver_time start_time = solver_now();
+    solve_stop depth_stop = solver_depth_cap(&max_depth, budget);
+
+    level reduced;
+    if (!solver_prepare(lvl, &reduced, &result)) return result;
+    lvl = &reduced;
+
+    sim_state start;
+    sim_init(&start, lvl);
+    if (sim_is_solved(&start)) {
+        solver_mark_solved(&result, 0, budget);
+        result.states_explored = 1;
+        result.peak_bytes = sizeof(sim_state);
+        return result;
+    }
+
+    ext_layout layout;
+    ext_layout_init(&layout, lvl);
+    i32 rs = layout.record_size;
+    solver_context_begin(ctx, max_states, rs);
+    u64 bytes_per_node = rs + 2 * sizeof(u32) + sizeof(direction);
+    u64 table_bytes = ((u64)ctx->table_mask + 1) * sizeof(u64);
+
+    ext_pack(&layout, &start, ctx->records);
+    solver_context_insert(ctx, solver_record_hash(ctx->records, rs));
+    ctx->parents[0] = 0;
+    u32 count = 1;
+
+    result.lower_bound = 1;
+    result.stop = solve_stop::EXHAUSTED;
+    bool depth_capped = false;
+
+    // Nodes [head, layer_end) belong to `depth`, everything after to depth + 1
+    u32 head = 0;
+    u32 layer_end = 1;
+    i32 depth = 0;
+
+    while (head < count) {
+        if ((i32)count >= max_states) {
+            result.stop = solve_stop::STATE_LIMIT;
+            break;
+        }
+
+        result.peak_bytes = table_bytes + count * bytes_per_node;
+        if (solver_over_budget(&result, budget, start_time, result.states_explored)) break;
+
+        if (head == layer_end) {
+            layer_end = count;
+            depth++;
+        }
+        u32 node = head++;
+        result.states_explored++;
+
+        if (depth + 1 > result.lower_bound) result.lower_bound = depth + 1;
+        if (depth >= max_depth) {
+            depth_capped = true;
+            continue;
+        }
+
+        sim_state cur;
+        ext_unpack(&layout, lvl, ctx->records + (u64)node * rs, &cur);
+
+        for (i32 d = 0; d < 4; d++) {
+            direction dir = (direction)d;
+            if (dir == cur.current_gravity) continue;
+
+            sim_state next = cur;
+            sim_apply_move(&next, lvl, dir);
+
+            u8 *rec = ctx->records + (u64)count * rs;
+            ext_pack(&layout, &next, rec);
+            if (!solver_context_insert(ctx, solver_record_hash(rec, rs))) continue;
+
+            ctx->parents[count] = node;
+            ctx->moves[count] = dir;
+
+            if (sim_is_solved(&next)) {
+                solver_mark_solved(&result, depth + 1, budget);
+                result.states_explored++;
+                u32 at = count;
+                for (i32 m = depth; m >= 0; m--) {
+                    result.solution[m] = ctx->moves[at];
+                    at = ctx->parents[at];
+                }
+                result.peak_bytes = table_bytes + (count + 1) * bytes_per_node;
+                result.seconds = solver_seconds_since(start_time);
+                return result;
+            }
+            count++;
+        }
+    }
+
+    if (result.stop == solve_stop::EXHAUSTED && depth_capped) result.stop = depth_stop;
+    result.seconds = solver_seconds_since(start_time);
+    return result;
+}
+
+static void solver_batch_job(void *user, i32 worker, i32 index) {
+    solver_batch *b = (solver_batch *)user;
+    solver_params *p = &b->params;
+    if (p->bitboard) {
+        b->results[index] = solver_solve_bitboard(&b->levels[index], p->max_depth, p->max_states, p->budget);
+        return;
+    }
+    if (p->graph_stats) {
+        b->results[index] = solver_solve(&b->levels[index], p->max_depth, p->max_states,
+                                         &p->graph_stats[index], p->budget);
+        return;
+    }
+    b->results[index] = solver_solve_context(&b->contexts[worker], &b->levels[index],
+                                             p->max_depth, p->max_states, p->budget);
+}
+
+// Solves levels[0..count) in parallel, results[i] belongs to levels[i].
+// The pool and worker arenas persist across calls until solver_batch_shutdown.
+void solver_solve_batch(level *levels, i32 count, solver_params *params, solve_result *results) {
+    if (count <= 0) return;
+
+    solver_batch *b = g_solver_batch;
+    if (b && b->num_threads != params->num_threads) {
+        jobs_shutdown(&b->pool);
+    } else if (!b) {
+        b = g_solver_batch = new solver_batch();
+        b->num_threads = -1;
+    }
+    if (b->num_threads != params->num_threads) {
+        jobs_init(&b->pool, params->num_threads);
+        b->num_threads = params->num_threads;
+    }
+
+    if (!params->graph_stats && !params->bitboard) {
+        i32 record_size = 1;
+        for (i32 i = 0; i < count; i++) {
+            i32 rs = 1 + levels[i].num_crates + levels[i].num_gems;
+            if (rs > record_size) record_size = rs;
+        }
+        for (i32 w = 0; w < b->pool.num_workers; w++) {
+            solver_context_reserve(&b->contexts[w], params->max_states, record_size);
+        }
+    }
+
+    b->levels = levels;
+    b->results = results;
+    b->params = *params;
+    jobs_run(&b->pool, count, solver_batch_job, b);
+}
+
+void solver_batch_shutdown() {
+    solver_batch *b = g_solver_batch;
+    if (!b) return;
+
+    jobs_shutdown(&b->pool);
+    for (i32 w = 0; w < JOBS_MAX_WORKERS; w++) {
+        if (b->contexts[w].arena.base) mem_arena_clear(&b->contexts[w].arena);
+    }
+    delete b;
+    g_solver_batch = nullptr;
+}
@@ -0,0 +1,538 @@
+#include <ctime>
+#include <direct.h>
+#include <algorithm>
+#include <vector>
+
+// External-memory BFS: every layer lives on disk as a sorted file of fixed-size
+// packed states. Successors are buffered up to a memory budget, sorted into runs,
+// then merged and deduplicated against all earlier layers in one streaming pass
+// (delayed duplicate detection). Memory stays bounded by the budget no matter how
+// large the state space gets; disk usage grows with the number of visited states.
+//
+// Packed state (canonical, 1 + num_crates + num_gems bytes):
+//   u8 gravity
+//   u8 crates[num_crates]   pack_pos, sorted
+//   u8 gems[num_gems]       pack_pos or EXT_GEM_INACTIVE, sorted within each color
+
+#define EXT_GEM_INACTIVE 0xFF
+#define EXT_MAX_RECORD (1 + ELEMENTS_MAX_NUM * 2)
+#define EXT_READ_BUFFER (256 * 1024)
+#define EXT_MERGE_FAN_IN 32
+#define EXT_DEFAULT_MEM_BUDGET (256ull * 1024 * 1024)
+#define EXT_DEFAULT_MAX_STATES 500000000
+
+struct ext_params {
+    const char *spill_dir;
+    u64 mem_budget;         // Bytes for the successor sort buffer
+};
+
+struct ext_layout {
+    i32 record_size;
+    i32 num_colors;
+    i32 color_count[3];
+    i32 color_gems[3][ELEMENTS_MAX_NUM]; // Gem indices of each color, ascending
+};
+
+static void ext_layout_init(ext_layout *l, level *lvl) {
+    memset(l, 0, sizeof(ext_layout));
+    l->record_size = 1 + lvl->num_crates + lvl->num_gems;
+    for (i32 i = 0; i < lvl->num_gems; i++) {
+        i32 c = (i32)lvl->gem_colors[i];
+        l->color_gems[c][l->color_count[c]++] = i;
+    }
+}
+
+static void ext_sort_bytes(u8 *v, i32 n) {
+    for (i32 i = 1; i < n; i++) {
+        u8 key = v[i];
+        i32 j = i - 1;
+        while (j >= 0 && v[j] > key) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = key;
+    }
+}
+
+static void ext_pack(ext_layout *l, sim_state *s, u8 *out) {
+    u8 *p = out;
+    *p++ = (u8)s->current_gravity;
+
+    for (i32 i = 0; i < s->num_crates; i++) p[i] = pack_pos(s->crates[i]);
+    ext_sort_bytes(p, s->num_crates);
+    p += s->num_crates;
+
+    // Same-color gems are interchangeable, so only the sorted multiset per color matters
+    for (i32 c = 0; c < 3; c++) {
+        for (i32 k = 0; k < l->color_count[c]; k++) {
+            i32 g = l->color_gems[c][k];
+            p[k] = ((s->gems_active >> g) & 1) ? pack_pos(s->gems[g]) : EXT_GEM_INACTIVE;
+        }
+        ext_sort_bytes(p, l->color_count[c]);
+        p += l->color_count[c];
+    }
+}
+
+static void ext_unpack(ext_layout *l, level *lvl, const u8 *in, sim_state *s) {
+    sim_init(s, lvl);
+    const u8 *p = in;
+    s->current_gravity = (direction)*p++;
+
+    for (i32 i = 0; i < s->num_crates; i++) s->crates[i] = unpack_pos(p[i]);
+    p += s->num_crates;
+
+    s->gems_active = 0;
+    for (i32 c = 0; c < 3; c++) {
+        for (i32 k = 0; k < l->color_count[c]; k++) {
+            i32 g = l->color_gems[c][k];
+            if (p[k] != EXT_GEM_INACTIVE) {
+                s->gems[g] = unpack_pos(p[k]);
+                s->gems_active |= 1u << g;
+            }
+        }
+        p += l->color_count[c];
+    }
+}
+
+// Buffered sequential reader over a file of fixed-size records
+struct ext_reader {
+    FILE *f;
+    u8 *buf;
+    u64 len;
+    u64 pos;
+    i32 record_size;
+    bool failed;        // A read failed, peek then ends early as if the file did
+};
+
+// r can be closed even when this fails
+static bool ext_reader_open(ext_reader *r, const char *path, i32 record_size) {
+    memset(r, 0, sizeof(ext_reader));
+    r->record_size = record_size;
+    if (fopen_s(&r->f, path, "rb") != 0 || !r->f) return false;
+    r->buf = (u8 *)malloc(EXT_READ_BUFFER);
+    return true;
+}
+
+// Current record, or nullptr at end of file
+static const u8 *ext_reader_peek(ext_reader *r) {
+    if (r->pos + r->record_size > r->len) {
+        if (!r->f) return nullptr;
+        u64 per_read = (EXT_READ_BUFFER / r->record_size) * r->record_size;
+        r->len = fread(r->buf, 1, per_read, r->f);
+        r->pos = 0;
+        if (r->len < per_read && ferror(r->f)) r->failed = true;
+        if (r->len < (u64)r->record_size) return nullptr;
+    }
+    return r->buf + r->pos;
+}
+
+static void ext_reader_next(ext_reader *r) {
+    r->pos += r->record_size;
+}
+
+static void ext_reader_close(ext_reader *r) {
+    if (r->f) fclose(r->f);
+    free(r->buf);
+    memset(r, 0, sizeof(ext_reader));
+}
+
+static FILE *ext_open_write(const char *path) {
+    FILE *f;
+    if (fopen_s(&f, path, "wb") != 0 || !f) return nullptr;
+    setvbuf(f, nullptr, _IOFBF, EXT_READ_BUFFER);
+    return f;
+}
+
+struct ext_search {
+    level *lvl;
+    ext_layout layout;
+    const char *dir;
+    u32 session;
+
+    u8 *buf;                // Successor buffer
+    u64 buf_cap;            // In records
+    u64 buf_count;
+    std::vector<u32> order; // Sort permutation over buf
+
+    i32 num_runs;
+    i32 run_gen;            // Bumped per merge pass so run names never collide
+};
+
+static void ext_layer_path(ext_search *es, i32 depth, char *out, u64 out_len) {
+    snprintf(out, out_len, "%s/pgext_%u_layer_%03d.bin", es->dir, es->session, depth);
+}
+
+static void ext_run_path(ext_search *es, i32 gen, i32 run, char *out, u64 out_len) {
+    snprintf(out, out_len, "%s/pgext_%u_run_%d_%05d.bin", es->dir, es->session, gen, run);
+}
+
+// Sorts the successor buffer and writes it out as one duplicate-free run
+static bool ext_flush_run(ext_search *es) {
+    if (es->buf_count == 0) return true;
+
+    i32 rs = es->layout.record_size;
+    u8 *buf = es->buf;
+    es->order.resize(es->buf_count);
+    for (u32 i = 0; i < (u32)es->buf_count; i++) es->order[i] = i;
+    std::sort(es->order.begin(), es->order.end(), [buf, rs](u32 a, u32 b) {
+        return memcmp(buf + (u64)a * rs, buf + (u64)b * rs, rs) < 0;
+    });
+
+    char path[512];
+    ext_run_path(es, es->run_gen, es->num_runs, path, sizeof(path));
+    FILE *f = ext_open_write(path);
+    if (!f) return false;
+
+    bool ok = true;
+    const u8 *prev = nullptr;
+    for (u64 i = 0; i < es->buf_count && ok; i++) {
+        const u8 *rec = buf + (u64)es->order[i] * rs;
+        if (prev && memcmp(prev, rec, rs) == 0) continue;
+        ok = fwrite(rec, rs, 1, f) == 1;
+        prev = rec;
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        remove(path);
+        return false;
+    }
+
+    es->num_runs++;
+    es->buf_count = 0;
+    return true;
+}
+
+// Streams the union of `count` sorted runs into `out`, dropping duplicates and anything
+// present in `exclude` (sorted earlier layers). Returns the number of records written,
+// -1 if a read or write failed.
+static i64 ext_merge(ext_search *es, ext_reader *runs, i32 count, ext_reader *exclude, i32 num_exclude, FILE *out) {
+    i32 rs = es->layout.record_size;
+    i64 written = 0;
+    u8 last[EXT_MAX_RECORD];
+    bool has_last = false;
+
+    while (true) {
+        const u8 *best = nullptr;
+        i32 best_run = -1;
+        for (i32 i = 0; i < count; i++) {
+            const u8 *rec = ext_reader_peek(&runs[i]);
+            if (rec && (!best || memcmp(rec, best, rs) < 0)) {
+                best = rec;
+                best_run = i;
+            }
+        }
+        if (!best) break;
+
+        u8 cur[EXT_MAX_RECORD];
+        memcpy(cur, best, rs);
+        ext_reader_next(&runs[best_run]);
+
+        if (has_last && memcmp(cur, last, rs) == 0) continue;
+        memcpy(last, cur, rs);
+        has_last = true;
+
+        bool seen = false;
+        for (i32 e = 0; e < num_exclude && !seen; e++) {
+            const u8 *rec = ext_reader_peek(&exclude[e]);
+            while (rec && memcmp(rec, cur, rs) < 0) {
+                ext_reader_next(&exclude[e]);
+                rec = ext_reader_peek(&exclude[e]);
+            }
+            seen = rec && memcmp(rec, cur, rs) == 0;
+        }
+        if (seen) continue;
+
+        if (fwrite(cur, rs, 1, out) != 1) return -1;
+        written++;
+    }
+
+    for (i32 i = 0; i < count; i++) {
+        if (runs[i].failed) return -1;
+    }
+    for (i32 e = 0; e < num_exclude; e++) {
+        if (exclude[e].failed) return -1;
+    }
+    return written;
+}
+
+// Folds runs down to at most EXT_MERGE_FAN_IN files so the final merge stays within handle limits
+static bool ext_reduce_runs(ext_search *es) {
+    while (es->num_runs > EXT_MERGE_FAN_IN) {
+        i32 next_gen = es->run_gen + 1;
+        i32 next_runs = 0;
+        for (i32 first = 0; first < es->num_runs; first += EXT_MERGE_FAN_IN) {
+            i32 count = es->num_runs - first < EXT_MERGE_FAN_IN ? es->num_runs - first : EXT_MERGE_FAN_IN;
+
+            ext_reader readers[EXT_MERGE_FAN_IN];
+            char path[512];
+            bool ok = true;
+            for (i32 i = 0; i < count; i++) {
+                ext_run_path(es, es->run_gen, first + i, path, sizeof(path));
+                ok = ext_reader_open(&readers[i], path, es->layout.record_size) && ok;
+            }
+
+            ext_run_path(es, next_gen, next_runs++, path, sizeof(path));
+            FILE *out = ok ? ext_open_write(path) : nullptr;
+            if (out) {
+                ok = ext_merge(es, readers, count, nullptr, 0, out) >= 0;
+                ok = fclose(out) == 0 && ok;
+            } else {
+                ok = false;
+            }
+
+            for (i32 i = 0; i < count; i++) {
+                ext_reader_close(&readers[i]);
+            }
+            if (!ok) {
+                // ext_cleanup only knows the current generation, drop what this pass wrote
+                for (i32 i = 0; i < next_runs; i++) {
+                    ext_run_path(es, next_gen, i, path, sizeof(path));
+                    remove(path);
+                }
+                return false;
+            }
+            for (i32 i = 0; i < count; i++) {
+                ext_run_path(es, es->run_gen, first + i, path, sizeof(path));
+                remove(path);
+            }
+        }
+        es->run_gen = next_gen;
+        es->num_runs = next_runs;
+    }
+    return true;
+}
+
+// Walks back from a parent state in layer `depth` to the root, filling in moves[0..depth).
+// False if a layer can't be read or has no parent for the state, moves is then incomplete.
+static bool ext_reconstruct(ext_search *es, i32 depth, u8 *target, direction *moves) {
+    i32 rs = es->layout.record_size;
+    for (i32 k = depth - 1; k >= 0; k--) {
+        char path[512];
+        ext_layer_path(es, k, path, sizeof(path));
+        ext_reader r;
+        if (!ext_reader_open(&r, path, rs)) {
+            ext_reader_close(&r);
+            return false;
+        }
+
+        bool found = false;
+        for (const u8 *rec = ext_reader_peek(&r); rec && !found; ext_reader_next(&r), rec = ext_reader_peek(&r)) {
+            sim_state s;
+            ext_unpack(&es->layout, es->lvl, rec, &s);
+            for (i32 d = 0; d < 4 && !found; d++) {
+                if ((direction)d == s.current_gravity) continue;
+                sim_state next = s;
+                sim_apply_move(&next, es->lvl, (direction)d);
+
+                u8 packed[EXT_MAX_RECORD];
+                ext_pack(&es->layout, &next, packed);
+                if (memcmp(packed, target, rs) == 0) {
+                    moves[k] = (direction)d;
+                    memcpy(target, rec, rs);
+                    found = true;
+                }
+            }
+        }
+        ext_reader_close(&r);
+        if (!found) return false;
+    }
+    return true;
+}
+
+static void ext_cleanup(ext_search *es, i32 num_layers) {
+    char path[512];
+    for (i32 d = 0; d < num_layers; d++) {
+        ext_layer_path(es, d, path, sizeof(path));
+        remove(path);
+    }
+    for (i32 i = 0; i < es->num_runs; i++) {
+        ext_run_path(es, es->run_gen, i, path, sizeof(path));
+        remove(path);
+    }
+    free(es->buf);
+}
+
+// Same contract as solver_solve, with max_states counted over the whole search.
+// Memory is bounded by ext_params::mem_budget, so solve_budget::max_bytes is not checked here.
+solve_result solver_solve_external(level *lvl, i32 max_depth, i64 max_states, ext_params *p,
+                                   solve_budget *budget = nullptr) {
+    static u32 s_session = 0;
+
+    solve_result result = {};
+    solver_time start_time = solver_now();
+    solve_stop depth_stop = solver_depth_cap(&max_depth, budget);
+
+    level reduced;
+    if (!solver_prepare(lvl, &reduced, &result)) return result;
+    lvl = &reduced;
+
+    sim_state start;
+    sim_init(&start, lvl);
+    if (sim_is_solved(&start)) {
+        solver_mark_solved(&result, 0, budget);
+        result.states_explored = 1;
+        return result;
+    }
+    result.lower_bound = 1;
+    result.stop = solve_stop::IO_ERROR;
+
+    ext_search es = {};
+    es.lvl = lvl;
+    es.dir = p->spill_dir;
+    es.session = ((u32)time(nullptr) << 8) ^ s_session++;
+    ext_layout_init(&es.layout, lvl);
+    i32 rs = es.layout.record_size;
+
+    es.buf_cap = p->mem_budget / (rs + sizeof(u32)); // Record + its sort index
+    if (es.buf_cap < 1024) es.buf_cap = 1024;
+    es.buf = (u8 *)malloc(es.buf_cap * rs);
+    result.peak_bytes = es.buf_cap * (rs + sizeof(u32)) + (u64)(EXT_MERGE_FAN_IN + max_depth + 1) * EXT_READ_BUFFER;
+
+    _mkdir(es.dir);
+
+    char path[512];
+    ext_layer_path(&es, 0, path, sizeof(path));
+    FILE *root_file = ext_open_write(path);
+    if (!root_file) {
+        free(es.buf);
+        result.seconds = solver_seconds_since(start_time);
+        return result;
+    }
+    u8 root[EXT_MAX_RECORD];
+    ext_pack(&es.layout, &start, root);
+    bool root_ok = fwrite(root, rs, 1, root_file) == 1;
+    root_ok = fclose(root_file) == 0 && root_ok;
+    if (!root_ok) {
+        ext_cleanup(&es, 1);
+        result.seconds = solver_seconds_since(start_time);
+        return result;
+    }
+
+    i64 total_states = 1;
+    i32 depth = 0;
+    bool timed_out = false;
+    for (; depth < max_depth && !timed_out; depth++) {
+        // Expand layer `depth` into sorted runs
+        ext_reader layer;
+        ext_layer_path(&es, depth, path, sizeof(path));
+        es.num_runs = 0;
+        if (!ext_reader_open(&layer, path, rs)) {
+            ext_reader_close(&layer);
+            ext_cleanup(&es, depth + 1);
+            result.seconds = solver_seconds_since(start_time);
+            return result;
+        }
+
+        for (const u8 *rec = ext_reader_peek(&layer); rec; ext_reader_next(&layer), rec = ext_reader_peek(&layer)) {
+            sim_state s;
+            ext_unpack(&es.layout, lvl, rec, &s);
+            result.states_explored++;
+
+            // Partial runs of this layer are removed by ext_cleanup
+            if (budget && budget->max_seconds > 0.0 && !timed_out &&
+                (result.states_explored % SOLVER_BUDGET_CHECK_INTERVAL) == 0 &&
+                solver_seconds_since(start_time) > budget->max_seconds) {
+                timed_out = true;
+                break;
+            }
+
+            for (i32 d = 0; d < 4; d++) {
+                if ((direction)d == s.current_gravity) continue;
+
+                sim_state next = s;
+                sim_apply_move(&next, lvl, (direction)d);
+
+                if (sim_is_solved(&next)) {
+                    u8 target[EXT_MAX_RECORD];
+                    memcpy(target, rec, rs);
+                    result.solution[depth] = (direction)d;
+                    result.states_explored++;
+                    ext_reader_close(&layer);
+                    // Without every parent there is no path to report, only that none is shorter
+                    if (ext_reconstruct(&es, depth, target, result.solution)) {
+                        solver_mark_solved(&result, depth + 1, budget);
+                    } else {
+                        result.lower_bound = depth + 1;
+                    }
+                    ext_cleanup(&es, depth + 1);
+                    result.seconds = solver_seconds_since(start_time);
+                    return result;
+                }
+
+                ext_pack(&es.layout, &next, es.buf + es.buf_count * rs);
+                es.buf_count++;
+                if (es.buf_count == es.buf_cap && !ext_flush_run(&es)) {
+                    ext_reader_close(&layer);
+                    ext_cleanup(&es, depth + 1);
+                    result.seconds = solver_seconds_since(start_time);
+                    return result;
+                }
+            }
+        }
+        bool layer_failed = layer.failed;
+        ext_reader_close(&layer);
+        if (layer_failed) {
+            ext_cleanup(&es, depth + 1);
+            result.seconds = solver_seconds_since(start_time);
+            return result;
+        }
+        if (timed_out) {
+            result.stop = solve_stop::TIME_LIMIT;
+            depth++;
+            break;
+        }
+        if (!ext_flush_run(&es) || !ext_reduce_runs(&es)) {
+            ext_cleanup(&es, depth + 1);
+            result.seconds = solver_seconds_since(start_time);
+            return result;
+        }
+        result.lower_bound = depth + 2;
+
+        // Merge runs, dropping anything already seen in layers 0..depth
+        bool opened = true;
+        ext_reader runs[EXT_MERGE_FAN_IN];
+        for (i32 i = 0; i < es.num_runs; i++) {
+            ext_run_path(&es, es.run_gen, i, path, sizeof(path));
+            opened = ext_reader_open(&runs[i], path, rs) && opened;
+        }
+        ext_reader earlier[SOLVER_MAX_MOVES + 1];
+        for (i32 k = 0; k <= depth; k++) {
+            ext_layer_path(&es, k, path, sizeof(path));
+            opened = ext_reader_open(&earlier[k], path, rs) && opened;
+        }
+
+        ext_layer_path(&es, depth + 1, path, sizeof(path));
+        FILE *out = opened ? ext_open_write(path) : nullptr;
+        i64 added = out ? ext_merge(&es, runs, es.num_runs, earlier, depth + 1, out) : -1;
+        if (out && fclose(out) != 0) added = -1;
+
+        for (i32 i = 0; i < es.num_runs; i++) {
+            ext_reader_close(&runs[i]);
+            ext_run_path(&es, es.run_gen, i, path, sizeof(path));
+            remove(path);
+        }
+        es.num_runs = 0;
+        for (i32 k = 0; k <= depth; k++) ext_reader_close(&earlier[k]);
+
+        if (added < 0) {
+            // Layer depth + 1 may exist half written, ext_cleanup takes it too
+            ext_cleanup(&es, depth + 2);
+            result.seconds = solver_seconds_since(start_time);
+            return result;
+        }
+
+        total_states += added;
+        if (added == 0 || total_states >= max_states) {
+            result.stop = added == 0 ? solve_stop::EXHAUSTED : solve_stop::STATE_LIMIT;
+            depth++;
+            break;
+        }
+    }
+
+    // Ran out of layers with states still queued
+    if (result.stop == solve_stop::IO_ERROR && depth == max_depth) result.stop = depth_stop;
+
+    ext_cleanup(&es, depth + 1);
+    result.seconds = solver_seconds_since(start_time);
+    return result;
+}
@@ -0,0 +1,224 @@
+#include <chrono>
+
+// Per-run telemetry: stage timings, rejection counts and histograms,
+// dumped as a JSON or CSV report at the end of a puzzlegen run.
+
+enum class pg_stage : u8 {
+    GENERATE,
+    FILTER,
+    SOLVE,
+    SCORE,
+    ASSEMBLE,
+    COUNT
+};
+
+static const char *pg_stage_names[(u8)pg_stage::COUNT] = {
+    "generate", "filter", "solve", "score", "assemble",
+};
+
+#define STATS_HIST_BUCKETS 16
+
+struct stats_histogram {
+    const char *name;
+    f64 lo, hi;     // Linear bucket range (ignored for log2 histograms)
+    bool log2;      // Bucket i holds values in [2^i, 2^(i+1)), bucket 0 holds [0, 2)
+    u64 buckets[STATS_HIST_BUCKETS];
+    u64 count;
+    f64 sum;
+    f64 min, max;
+};
+
+struct pg_stats {
+    f64 stage_seconds[(u8)pg_stage::COUNT];
+    u64 stage_calls[(u8)pg_stage::COUNT];
+    f64 total_seconds;
+
+    i32 candidates;
+    i32 rejected_generate;  // gen_random_level could not place elements
+    i32 rejected_filter;    // gen_filter_level rejected the layout
+    i32 rejected_unsolved;  // Solver found no solution within limits
+    i32 rejected_window;    // Optimal length outside the tier's move window
+    i32 rejected_similar;   // Too close to an accepted puzzle (novelty index)
+    i32 accepted;
+    i32 bundles_written;
+
+    u64 solver_peak_bytes;  // Max over all solver_solve calls
+    i32 solve_stops[(u8)solve_stop::COUNT];
+
+    stats_histogram states_explored;
+    stats_histogram optimal_moves;
+    stats_histogram difficulty;
+};
+
+typedef std::chrono::steady_clock::time_point stats_time;
+
+static inline stats_time stats_now() {
+    return std::chrono::steady_clock::now();
+}
+
+static inline f64 stats_seconds_since(stats_time start) {
+    return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void stats_hist_init(stats_histogram *h, const char *name, f64 lo, f64 hi, bool log2) {
+    memset(h, 0, sizeof(stats_histogram));
+    h->name = name;
+    h->lo = lo;
+    h->hi = hi;
+    h->log2 = log2;
+}
+
+void stats_init(pg_stats *s, i32 max_solve_moves) {
+    memset(s, 0, sizeof(pg_stats));
+    stats_hist_init(&s->states_explored, "states_explored", 0.0, 0.0, true);
+    stats_hist_init(&s->optimal_moves, "optimal_moves", 0.0, (f64)max_solve_moves + 1.0, false);
+    stats_hist_init(&s->difficulty, "difficulty", 0.0, 1.0, false);
+}
+
+void stats_hist_add(stats_histogram *h, f64 v) {
+    i32 b = 0;
+    if (h->log2) {
+        u64 iv = v < 1.0 ? 0 : (u64)v;
+        while (iv > 1 && b < STATS_HIST_BUCKETS - 1) { iv >>= 1; b++; }
+    } else {
+        b = (i32)((v - h->lo) / (h->hi - h->lo) * STATS_HIST_BUCKETS);
+        if (b < 0) b = 0;
+        if (b >= STATS_HIST_BUCKETS) b = STATS_HIST_BUCKETS - 1;
+    }
+    h->buckets[b]++;
+
+    if (h->count == 0 || v < h->min) h->min = v;
+    if (h->count == 0 || v > h->max) h->max = v;
+    h->count++;
+    h->sum += v;
+}
+
+void stats_stage_add(pg_stats *s, pg_stage stage, stats_time start) {
+    s->stage_seconds[(u8)stage] += stats_seconds_since(start);
+    s->stage_calls[(u8)stage]++;
+}
+
+void stats_record_solve(pg_stats *s, solve_result *sol) {
+    stats_hist_add(&s->states_explored, (f64)sol->states_explored);
+    if (sol->solvable) stats_hist_add(&s->optimal_moves, (f64)sol->optimal_moves);
+    if (sol->peak_bytes > s->solver_peak_bytes) s->solver_peak_bytes = sol->peak_bytes;
+    s->solve_stops[(u8)sol->stop]++;
+}
+
+static f64 stats_bucket_lo(stats_histogram *h, i32 b) {
+    if (h->log2) return b == 0 ? 0.0 : (f64)(1ull << b);
+    return h->lo + (h->hi - h->lo) * b / STATS_HIST_BUCKETS;
+}
+
+static void stats_write_hist_json(FILE *f, stats_histogram *h, bool last) {
+    fprintf(f, "    \"%s\": {\n", h->name);
+    fprintf(f, "      \"count\": %llu, \"min\": %.4f, \"max\": %.4f, \"mean\": %.4f,\n",
+            h->count, h->min, h->max, h->count ? h->sum / h->count : 0.0);
+    fprintf(f, "      \"scale\": \"%s\",\n", h->log2 ? "log2" : "linear");
+    fprintf(f, "      \"bucket_lo\": [");
+    for (i32 b = 0; b < STATS_HIST_BUCKETS; b++) {
+        fprintf(f, "%s%.4f", b ? ", " : "", stats_bucket_lo(h, b));
+    }
+    fprintf(f, "],\n      \"buckets\": [");
+    for (i32 b = 0; b < STATS_HIST_BUCKETS; b++) {
+        fprintf(f, "%s%llu", b ? ", " : "", h->buckets[b]);
+    }
+    fprintf(f, "]\n    }%s\n", last ? "" : ",");
+}
+
+static bool stats_write_json(pg_stats *s, FILE *f, const char *version, i64 seed, const char *tier_name) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s\",\n", version);
+    fprintf(f, "  \"seed\": %lld,\n", seed);
+    fprintf(f, "  \"tier\": \"%s\",\n", tier_name);
+    fprintf(f, "  \"total_seconds\": %.6f,\n", s->total_seconds);
+    fprintf(f, "  \"candidates_per_second\": %.2f,\n",
+            s->total_seconds > 0.0 ? s->candidates / s->total_seconds : 0.0);
+
+    fprintf(f, "  \"stages\": {\n");
+    for (u8 i = 0; i < (u8)pg_stage::COUNT; i++) {
+        fprintf(f, "    \"%s\": { \"seconds\": %.6f, \"calls\": %llu }%s\n",
+                pg_stage_names[i], s->stage_seconds[i], s->stage_calls[i],
+                i + 1 < (u8)pg_stage::COUNT ? "," : "");
+    }
+    fprintf(f, "  },\n");
+
+    fprintf(f, "  \"counts\": {\n");
+    fprintf(f, "    \"candidates\": %d,\n", s->candidates);
+    fprintf(f, "    \"rejected_generate\": %d,\n", s->rejected_generate);
+    fprintf(f, "    \"rejected_filter\": %d,\n", s->rejected_filter);
+    fprintf(f, "    \"rejected_unsolved\": %d,\n", s->rejected_unsolved);
+    fprintf(f, "    \"rejected_window\": %d,\n", s->rejected_window);
+    fprintf(f, "    \"rejected_similar\": %d,\n", s->rejected_similar);
+    fprintf(f, "    \"accepted\": %d,\n", s->accepted);
+    fprintf(f, "    \"bundles_written\": %d\n", s->bundles_written);
+    fprintf(f, "  },\n");
+
+    fprintf(f, "  \"solver_peak_bytes\": %llu,\n", s->solver_peak_bytes);
+
+    fprintf(f, "  \"solver_stops\": {\n");
+    for (u8 i = 0; i < (u8)solve_stop::COUNT; i++) {
+        fprintf(f, "    \"%s\": %d%s\n", solve_stop_names[i], s->solve_stops[i],
+                i + 1 < (u8)solve_stop::COUNT ? "," : "");
+    }
+    fprintf(f, "  },\n");
+
+    fprintf(f, "  \"histograms\": {\n");
+    stats_write_hist_json(f, &s->states_explored, false);
+    stats_write_hist_json(f, &s->optimal_moves, false);
+    stats_write_hist_json(f, &s->difficulty, true);
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+    return !ferror(f);
+}
+
+// Flat "section,key,value" rows so runs can be concatenated and diffed easily
+static bool stats_write_csv(pg_stats *s, FILE *f, const char *version, i64 seed, const char *tier_name) {
+    fprintf(f, "section,key,value\n");
+    fprintf(f, "run,version,%s\n", version);
+    fprintf(f, "run,seed,%lld\n", seed);
+    fprintf(f, "run,tier,%s\n", tier_name);
+    fprintf(f, "run,total_seconds,%.6f\n", s->total_seconds);
+
+    for (u8 i = 0; i < (u8)pg_stage::COUNT; i++) {
+        fprintf(f, "stage_seconds,%s,%.6f\n", pg_stage_names[i], s->stage_seconds[i]);
+        fprintf(f, "stage_calls,%s,%llu\n", pg_stage_names[i], s->stage_calls[i]);
+    }
+
+    fprintf(f, "counts,candidates,%d\n", s->candidates);
+    fprintf(f, "counts,rejected_generate,%d\n", s->rejected_generate);
+    fprintf(f, "counts,rejected_filter,%d\n", s->rejected_filter);
+    fprintf(f, "counts,rejected_unsolved,%d\n", s->rejected_unsolved);
+    fprintf(f, "counts,rejected_window,%d\n", s->rejected_window);
+    fprintf(f, "counts,rejected_similar,%d\n", s->rejected_similar);
+    fprintf(f, "counts,accepted,%d\n", s->accepted);
+    fprintf(f, "counts,bundles_written,%d\n", s->bundles_written);
+    fprintf(f, "solver,peak_bytes,%llu\n", s->solver_peak_bytes);
+    for (u8 i = 0; i < (u8)solve_stop::COUNT; i++) {
+        fprintf(f, "solver_stops,%s,%d\n", solve_stop_names[i], s->solve_stops[i]);
+    }
+
+    stats_histogram *hists[] = { &s->states_explored, &s->optimal_moves, &s->difficulty };
+    for (stats_histogram *h : hists) {
+        for (i32 b = 0; b < STATS_HIST_BUCKETS; b++) {
+            fprintf(f, "hist_%s,%.4f,%llu\n", h->name, stats_bucket_lo(h, b), h->buckets[b]);
+        }
+    }
+    return !ferror(f);
+}
+
+// Format is picked from the extension: ".csv" writes CSV, anything else JSON
+bool stats_write_report(pg_stats *s, const char *path, const char *version, i64 seed, const char *tier_name) {
+    FILE *f;
+    i32 err = fopen_s(&f, path, "w");
+    if (err != 0 || !f) return false;
+
+    u64 len = strlen(path);
+    bool csv = len >= 4 && strcmp(path + len - 4, ".csv") == 0;
+
+    bool ok = csv ? stats_write_csv(s, f, version, seed, tier_name)
+                  : stats_write_json(s, f, version, seed, tier_name);
+    // A full disk may only show up when the buffer is flushed on close
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
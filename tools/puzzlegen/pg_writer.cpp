@@ -0,0 +1,147 @@
+#include <condition_variable>
+#include <cstdarg>
+#include <mutex>
+#include <thread>
+
+// Background batch writer: appends go into one of two large buffers while a dedicated
+// I/O thread writes the other out with a single sequential fwrite. The file is written
+// as <path>.tmp and only renamed to <path> by a successful batch_writer_close, so a
+// crashed or failed run never leaves a partial output behind under the real name.
+//
+// Bundle packs (bundle_output = "pack") use two of these per run:
+//   bundles_<tier>.bin   N bundles of 5 x 108-byte level records back to back; bundle i
+//                        starts at i * 540, so bundle 0 loads like a single bundle.bin
+//   bundles_<tier>.txt   the per-bundle metadata lines, prefixed with the bundle index
+
+#define WRITER_DEFAULT_BUFFER_SIZE (1024 * 1024)
+
+struct batch_writer {
+    FILE *file;
+    char path[256];
+    char tmp_path[260];
+
+    u8 *buffers[2];
+    u64 buffer_size;
+    u64 fill;               // Bytes in buffers[active]
+    i32 active;             // Buffer the caller appends to
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    u64 pending;            // Bytes of buffers[1 - active] queued for the I/O thread, 0 = none
+    bool quit;
+    bool failed;            // A write failed; everything after it is dropped
+    u64 bytes_written;
+};
+
+static void writer_thread(batch_writer *w) {
+    std::unique_lock<std::mutex> lock(w->mutex);
+    for (;;) {
+        w->wake.wait(lock, [&] { return w->pending > 0 || w->quit; });
+        if (w->pending == 0 && w->quit) return;
+
+        u8 *data = w->buffers[1 - w->active];
+        u64 size = w->pending;
+        bool failed = w->failed;
+        lock.unlock();
+
+        bool ok = failed || fwrite(data, size, 1, w->file) == 1;
+
+        lock.lock();
+        if (!ok) w->failed = true;
+        else if (!failed) w->bytes_written += size;
+        w->pending = 0;
+        w->idle.notify_all();
+    }
+}
+
+bool batch_writer_open(batch_writer *w, const char *path, u64 buffer_size = WRITER_DEFAULT_BUFFER_SIZE) {
+    snprintf(w->path, sizeof(w->path), "%s", path);
+    snprintf(w->tmp_path, sizeof(w->tmp_path), "%s.tmp", path);
+
+    i32 err = fopen_s(&w->file, w->tmp_path, "wb");
+    if (err != 0 || !w->file) return false;
+    setvbuf(w->file, nullptr, _IONBF, 0); // Writes are already batched, skip the stdio copy
+
+    w->buffer_size = buffer_size > 0 ? buffer_size : WRITER_DEFAULT_BUFFER_SIZE;
+    w->buffers[0] = (u8 *)malloc(w->buffer_size);
+    w->buffers[1] = (u8 *)malloc(w->buffer_size);
+    w->fill = 0;
+    w->active = 0;
+    w->pending = 0;
+    w->quit = false;
+    w->failed = false;
+    w->bytes_written = 0;
+    w->thread = std::thread(writer_thread, w);
+    return true;
+}
+
+// Hands the active buffer to the I/O thread once it has finished the previous one
+static void batch_writer_swap(batch_writer *w) {
+    if (w->fill == 0) return;
+    std::unique_lock<std::mutex> lock(w->mutex);
+    w->idle.wait(lock, [&] { return w->pending == 0; });
+    w->pending = w->fill;
+    w->active = 1 - w->active;
+    w->fill = 0;
+    w->wake.notify_one();
+}
+
+void batch_writer_append(batch_writer *w, const void *data, u64 size) {
+    const u8 *src = (const u8 *)data;
+    while (size > 0) {
+        u64 room = w->buffer_size - w->fill;
+        u64 n = size < room ? size : room;
+        memcpy(w->buffers[w->active] + w->fill, src, n);
+        w->fill += n;
+        src += n;
+        size -= n;
+        if (w->fill == w->buffer_size) batch_writer_swap(w);
+    }
+}
+
+// printf-style append, for text records
+void batch_writer_printf(batch_writer *w, const char *fmt, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, fmt);
+    i32 n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n > 0) batch_writer_append(w, line, (u64)(n < (i32)sizeof(line) ? n : (i32)sizeof(line) - 1));
+}
+
+// Flushes, stops the I/O thread and renames the temp file into place.
+// On any failure the temp file is removed and nothing appears under path.
+bool batch_writer_close(batch_writer *w) {
+    batch_writer_swap(w);
+    {
+        std::unique_lock<std::mutex> lock(w->mutex);
+        w->idle.wait(lock, [&] { return w->pending == 0; });
+        w->quit = true;
+        w->wake.notify_one();
+    }
+    w->thread.join();
+
+    bool ok = !w->failed && fflush(w->file) == 0;
+    ok = fclose(w->file) == 0 && ok;
+    free(w->buffers[0]);
+    free(w->buffers[1]);
+    w->file = nullptr;
+
+    if (ok) ok = file_replace(w->tmp_path, w->path);
+    if (!ok) remove(w->tmp_path);
+    return ok;
+}
+
+// One bundle into a pack: the 5 level records, and its metadata lines
+void bundle_pack_append(batch_writer *bin, batch_writer *meta, bundle *b, i32 index) {
+    u8 data[5 * LEVEL_FILE_SIZE];
+    for (i32 i = 0; i < 5; i++) level_write_binary(&b->levels[i], data + i * LEVEL_FILE_SIZE);
+    batch_writer_append(bin, data, sizeof(data));
+
+    for (i32 i = 0; i < 5; i++) {
+        batch_writer_printf(meta, "bundle_%03d level_%d: difficulty=%.4f optimal_moves=%d\n",
+                            index, i, b->difficulty_scores[i], b->optimal_moves[i]);
+    }
+}
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <direct.h>
+#include <stdlib.h>
+
+#include "shared.hpp"
+#include "qg_config.hpp"
+#include "qg_random.hpp"
+
+// pgbench: times the simulation and solver hot paths on a frozen corpus, so a change to
+// pg_sim.cpp or pg_solver.cpp can be measured against the previous build. The corpus is
+// listed in a manifest (bench/corpus.txt): the game's bin/assets levels plus generated
+// levels per tier, checked in under bench/ and only regenerated on purpose (-g).
+// Results go out as JSON; every metric is the median over the timed repetitions.
+
+#define PGBENCH_VERSION "0.1"
+#define PGBENCH_DEFAULT_MANIFEST "bench/corpus.txt"
+#define PGBENCH_DEFAULT_SEED 85
+#define PGBENCH_SOLVE_DEPTH SOLVER_DEFAULT_DEPTH
+#define PGBENCH_SOLVE_STATES SOLVER_DEFAULT_MAX_STATES
+
+// Generated tiers, by optimal solution length
+struct pgbench_tier {
+    const char *name;
+    i32 min_moves;
+    i32 max_moves;
+};
+
+static const pgbench_tier pgbench_tiers[] = {
+    { "easy", 1, 4 },
+    { "medium", 5, 8 },
+    { "hard", 9, 12 },
+    { "expert", 13, PGBENCH_SOLVE_DEPTH },
+};
+#define PGBENCH_NUM_TIERS (i32)(sizeof(pgbench_tiers) / sizeof(pgbench_tiers[0]))
+
+struct pgbench_args {
+    const char *config_path;
+    const char *manifest_path;
+    const char *output_path;
+    i32 warmup;
+    i32 reps;
+    i32 generate;       // Levels per tier to regenerate, 0 = run the benchmark
+    i64 seed;
+};
+
+struct pgbench_group {
+    char name[32];
+    std::vector<level> levels;
+};
+
+struct pgbench_result {
+    i32 states;             // Sampled states the sim and hash timings run over
+    u64 moves;              // sim_apply_move calls per repetition
+    f64 move_ns;            // Per move
+    f64 hash_ns;            // Per state
+    u64 sim_checksum;       // Changes if sim or hash results change
+
+    i32 solved;
+    i64 solver_states;      // states_explored summed over the group
+    f64 solver_seconds;     // Whole group, per repetition
+    u64 solver_peak_bytes;  // Max solve_result::peak_bytes
+    i64 solver_moves;       // Sum of optimal_moves, changes if the solver's answers do
+};
+
+// False on an unknown or incomplete option, after printing the usage
+static bool pgbench_parse(pgbench_args *args, int argc, char **argv) {
+    args->config_path = "puzzlegen.cfg";
+    args->manifest_path = PGBENCH_DEFAULT_MANIFEST;
+    args->output_path = nullptr;
+    args->warmup = 1;
+    args->reps = 5;
+    args->generate = 0;
+    args->seed = PGBENCH_DEFAULT_SEED;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            args->config_path = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            args->manifest_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            args->output_path = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            args->warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            args->reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            args->generate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            args->seed = atoll(argv[++i]);
+        } else {
+            printf("Usage: pgbench.exe [options]\n");
+            printf("  -m <path>    Corpus manifest (default: %s)\n", PGBENCH_DEFAULT_MANIFEST);
+            printf("  -o <path>    JSON results (default: stdout)\n");
+            printf("  -w <count>   Warmup repetitions (default: 1)\n");
+            printf("  -r <count>   Timed repetitions (default: 5)\n");
+            printf("  -g <count>   Regenerate bench/<tier>.bin with <count> levels per tier and exit\n");
+            printf("  -c <path>    Generator config for -g (default: puzzlegen.cfg)\n");
+            printf("  -s <seed>    Generator seed for -g (default: %d)\n", PGBENCH_DEFAULT_SEED);
+            return false;
+        }
+    }
+    if (args->warmup < 0) args->warmup = 0;
+    if (args->reps < 1) args->reps = 1;
+    return true;
+}
+
+// Appends every record of a file of back-to-back 108-byte levels
+static bool pgbench_load_levels(const char *path, std::vector<level> *out) {
+    FILE *f;
+    i32 err = fopen_s(&f, path, "rb");
+    if (err != 0 || !f) return false;
+
+    u8 data[LEVEL_FILE_SIZE];
+    size_t read;
+    while ((read = fread(data, 1, LEVEL_FILE_SIZE, f)) == LEVEL_FILE_SIZE) {
+        level lvl;
+        level_read_binary(data, &lvl);
+        out->push_back(lvl);
+    }
+    fclose(f);
+    return read == 0;
+}
+
+// Manifest lines are "<group> <path>", # starts a comment. Files of the same group are merged.
+static bool pgbench_load_manifest(const char *path, std::vector<pgbench_group> *groups) {
+    FILE *f;
+    i32 err = fopen_s(&f, path, "r");
+    if (err != 0 || !f) {
+        printf("ERROR: Could not open manifest: %s\n", path);
+        return false;
+    }
+
+    char line[512];
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        char name[32], file[256];
+        if (line[0] == '#' || sscanf(line, "%31s %255s", name, file) != 2) continue;
+
+        pgbench_group *g = nullptr;
+        for (pgbench_group &it : *groups) {
+            if (strcmp(it.name, name) == 0) g = &it;
+        }
+        if (!g) {
+            groups->emplace_back();
+            g = &groups->back();
+            snprintf(g->name, sizeof(g->name), "%s", name);
+        }
+        if (!pgbench_load_levels(file, &g->levels)) {
+            printf("ERROR: Could not read levels: %s\n", file);
+            ok = false;
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+static f64 pgbench_median(std::vector<f64> &samples) {
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+static void pgbench_run_group(pgbench_group *g, pgbench_args *args, pgbench_result *r) {
+    memset(r, 0, sizeof(pgbench_result));
+
+    std::vector<sim_state> states;
+    std::vector<u32> state_level;
+    for (u32 i = 0; i < g->levels.size(); i++) {
+        bench_sample_states(&g->levels[i], &states);
+        state_level.resize(states.size(), i);
+    }
+    r->states = (i32)states.size();
+
+    std::vector<f64> move_times, hash_times, solve_times;
+    for (i32 rep = 0; rep < args->warmup + args->reps; rep++) {
+        bool timed = rep >= args->warmup;
+
+        // Every move out of every sampled state
+        u64 checksum = 0;
+        u64 moves = 0;
+        stats_time t = stats_now();
+        for (size_t i = 0; i < states.size(); i++) {
+            level *lvl = &g->levels[state_level[i]];
+            for (i32 d = 0; d < 4; d++) {
+                if ((direction)d == states[i].current_gravity) continue;
+                sim_state next = states[i];
+                sim_apply_move(&next, lvl, (direction)d);
+                checksum += next.gems_active + next.crates[0].x + next.gems[0].y;
+                moves++;
+            }
+        }
+        f64 move_seconds = stats_seconds_since(t);
+
+        t = stats_now();
+        for (size_t i = 0; i < states.size(); i++) checksum += sim_state_hash(&states[i]);
+        f64 hash_seconds = stats_seconds_since(t);
+
+        i32 solved = 0;
+        i64 solver_states = 0, solver_moves = 0;
+        u64 peak_bytes = 0;
+        t = stats_now();
+        for (level &lvl : g->levels) {
+            solve_result sol = solver_solve(&lvl, PGBENCH_SOLVE_DEPTH, PGBENCH_SOLVE_STATES);
+            solver_states += sol.states_explored;
+            if (sol.peak_bytes > peak_bytes) peak_bytes = sol.peak_bytes;
+            if (sol.solvable) {
+                solved++;
+                solver_moves += sol.optimal_moves;
+            }
+        }
+        f64 solve_seconds = stats_seconds_since(t);
+
+        if (!timed) continue;
+        move_times.push_back(move_seconds);
+        hash_times.push_back(hash_seconds);
+        solve_times.push_back(solve_seconds);
+        r->moves = moves;
+        r->sim_checksum = checksum;
+        r->solved = solved;
+        r->solver_states = solver_states;
+        r->solver_moves = solver_moves;
+        r->solver_peak_bytes = peak_bytes;
+    }
+
+    r->move_ns = r->moves > 0 ? pgbench_median(move_times) * 1e9 / r->moves : 0.0;
+    r->hash_ns = r->states > 0 ? pgbench_median(hash_times) * 1e9 / r->states : 0.0;
+    r->solver_seconds = pgbench_median(solve_times);
+}
+
+static void pgbench_write_json(FILE *f, pgbench_args *args, std::vector<pgbench_group> &groups,
+                               std::vector<pgbench_result> &results) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"version\": \"%s\",\n", PGBENCH_VERSION);
+    fprintf(f, "  \"manifest\": \"%s\",\n", args->manifest_path);
+    fprintf(f, "  \"warmup\": %d,\n", args->warmup);
+    fprintf(f, "  \"reps\": %d,\n", args->reps);
+    fprintf(f, "  \"solve_depth\": %d,\n", PGBENCH_SOLVE_DEPTH);
+    fprintf(f, "  \"solve_max_states\": %d,\n", PGBENCH_SOLVE_STATES);
+
+    fprintf(f, "  \"groups\": {\n");
+    for (size_t i = 0; i < groups.size(); i++) {
+        pgbench_result *r = &results[i];
+        f64 states_per_second = r->solver_seconds > 0.0 ? r->solver_states / r->solver_seconds : 0.0;
+        fprintf(f, "    \"%s\": {\n", groups[i].name);
+        fprintf(f, "      \"levels\": %d,\n", (i32)groups[i].levels.size());
+        fprintf(f, "      \"sim\": { \"states\": %d, \"moves\": %llu, \"ns_per_move\": %.2f, "
+                   "\"ns_per_hash\": %.2f, \"checksum\": %llu },\n",
+                r->states, r->moves, r->move_ns, r->hash_ns, r->sim_checksum);
+        fprintf(f, "      \"solver\": { \"solved\": %d, \"states\": %lld, \"seconds\": %.6f, "
+                   "\"states_per_second\": %.0f, \"peak_bytes\": %llu, \"optimal_moves\": %lld }\n",
+                r->solved, r->solver_states, r->solver_seconds, states_per_second,
+                r->solver_peak_bytes, r->solver_moves);
+        fprintf(f, "    }%s\n", i + 1 < groups.size() ? "," : "");
+    }
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+}
+
+// Regenerates the frozen tier files. Only for deliberately refreshing the corpus:
+// benchmark numbers from before and after a regeneration are not comparable.
+static bool pgbench_generate(pgbench_args *args) {
+    config cfg = {};
+    config_init(&cfg, args->config_path);
+    gen_params gp;
+    gen_params_from_config(&gp, &cfg);
+    config_free(&cfg);
+    rand_seed(args->seed);
+
+    std::vector<level> tiers[PGBENCH_NUM_TIERS];
+    i32 filled = 0;
+    i32 attempts = 0;
+    while (filled < PGBENCH_NUM_TIERS && attempts < args->generate * PGBENCH_NUM_TIERS * 1000) {
+        attempts++;
+        level lvl;
+        if (!gen_random_level(&lvl, &gp) || !gen_filter_level(&lvl)) continue;
+        solve_result sol = solver_solve(&lvl, PGBENCH_SOLVE_DEPTH, PGBENCH_SOLVE_STATES);
+        if (!sol.solvable) continue;
+
+        for (i32 t = 0; t < PGBENCH_NUM_TIERS; t++) {
+            const pgbench_tier *tier = &pgbench_tiers[t];
+            if (sol.optimal_moves < tier->min_moves || sol.optimal_moves > tier->max_moves) continue;
+            if ((i32)tiers[t].size() >= args->generate) break;
+            tiers[t].push_back(lvl);
+            if ((i32)tiers[t].size() == args->generate) filled++;
+            break;
+        }
+    }
+
+    _mkdir("bench");
+    bool ok = true;
+    for (i32 t = 0; t < PGBENCH_NUM_TIERS; t++) {
+        char path[256];
+        snprintf(path, sizeof(path), "bench/%s.bin", pgbench_tiers[t].name);
+        FILE *f;
+        i32 err = fopen_s(&f, path, "wb");
+        if (err != 0 || !f) {
+            printf("ERROR: Could not write %s\n", path);
+            ok = false;
+            continue;
+        }
+        for (level &lvl : tiers[t]) {
+            u8 data[LEVEL_FILE_SIZE];
+            level_write_binary(&lvl, data);
+            fwrite(data, LEVEL_FILE_SIZE, 1, f);
+        }
+        fclose(f);
+        printf("Wrote %s: %d levels (%d-%d moves)\n", path, (i32)tiers[t].size(),
+               pgbench_tiers[t].min_moves, pgbench_tiers[t].max_moves);
+    }
+    printf("seed=%lld attempts=%d\n", args->seed, attempts);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    pgbench_args args;
+    if (!pgbench_parse(&args, argc, argv)) return 1;
+
+    if (args.generate > 0) return pgbench_generate(&args) ? 0 : 1;
+
+    std::vector<pgbench_group> groups;
+    if (!pgbench_load_manifest(args.manifest_path, &groups)) return 1;
+
+    std::vector<pgbench_result> results(groups.size());
+    for (size_t i = 0; i < groups.size(); i++) {
+        fprintf(stderr, "pgbench: %s (%d levels)\n", groups[i].name, (i32)groups[i].levels.size());
+        pgbench_run_group(&groups[i], &args, &results[i]);
+    }
+
+    if (!args.output_path) {
+        pgbench_write_json(stdout, &args, groups, results);
+        return 0;
+    }
+    FILE *f;
+    i32 err = fopen_s(&f, args.output_path, "w");
+    if (err != 0 || !f) {
+        printf("ERROR: Could not write results: %s\n", args.output_path);
+        return 1;
+    }
+    pgbench_write_json(f, &args, groups, results);
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,27 @@
+// Engine modules (SDL-free)
+#include "../../engine/qg_memory.cpp"
+#include "../../engine/qg_random.cpp"
+#include "../../engine/qg_parse.cpp"
+
+// Puzzlegen modules
+#include "pg_config.cpp"
+#include "pg_level_io.cpp"
+#include "pg_level_columns.cpp"
+#include "pg_sim.cpp"
+#include "pg_reduce.cpp"
+#include "pg_solver.cpp"
+#include "pg_solver_ext.cpp"
+#include "pg_bitboard.cpp"
+#include "pg_jobs.cpp"
+#include "pg_solver_batch.cpp"
+#include "pg_gen.cpp"
+#include "pg_playout.cpp"
+#include "pg_difficulty.cpp"
+#include "pg_novelty.cpp"
+#include "pg_bundle.cpp"
+#include "pg_hints.cpp"
+#include "pg_writer.cpp"
+#include "pg_archive.cpp"
+#include "pg_stats.cpp"
+#include "pg_bench.cpp"
+#include "pgbench_main.cpp"